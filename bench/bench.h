@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <print>
+#include <string_view>
+#include <vector>
+
+namespace bench
+{
+
+// Batch sizes every kernel is measured at.
+inline const std::vector<size_t> BATCH_SIZES = { 1, 10, 100, 1'000, 10'000, 100'000, 1'000'000 };
+
+// Minimal time a single measurement runs for.
+constexpr std::chrono::milliseconds MIN_DURATION{ 50 };
+
+/**
+ * @brief Keeps the compiler from optimizing away the computation of the value.
+ */
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Prints the header of the result table.
+ */
+inline void header(std::string_view suite)
+{
+	std::println("\n{}", suite);
+	std::println("{:<28} {:>10} {:>12} {:>14}", "benchmark", "batch", "ns/op", "Mop/s");
+}
+
+/**
+ * @brief Measures a kernel processing a batch of elements and prints ns per element and throughput.
+ * The kernel is warmed up once, then repeated until the run takes at least MIN_DURATION.
+ *
+ * @param name Name of the benchmark.
+ * @param batch Number of elements processed by a single call of the kernel.
+ * @param kernel Function processing the whole batch.
+ * @return double Nanoseconds per element.
+ */
+template <typename Kernel>
+double run(std::string_view name, size_t batch, Kernel &&kernel)
+{
+	using Clock = std::chrono::steady_clock;
+
+	kernel();
+
+	size_t iterations = 0;
+	auto start = Clock::now();
+	auto elapsed = Clock::duration::zero();
+	while (elapsed < MIN_DURATION) {
+		kernel();
+		++iterations;
+		elapsed = Clock::now() - start;
+	}
+
+	double ns = std::chrono::duration<double, std::nano>(elapsed).count() / (iterations * batch);
+	std::println("{:<28} {:>10} {:>12.2f} {:>14.2f}", name, batch, ns, 1e3 / ns);
+	return ns;
+}
+
+}
@@ -0,0 +1,169 @@
+#include "bench_body.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+constexpr float DT = 1.0f / 240.0f;
+
+/**
+ * @brief Fills the body store with the given number of bodies with random poses and torques.
+ */
+template <typename S = float>
+std::vector<rl::BodyStore::Handle> spawn(size_t count)
+{
+	auto &store = rl::BasicBodyStore<S>::instance();
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+	Matrix3f inertia;
+	inertia << 2, 0, 0,
+			   0, 2, 0,
+			   0, 0, 4;
+
+	std::vector<rl::BodyStore::Handle> handles;
+	handles.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		Vector3 position{ value(rng) * 100.0f, value(rng) * 100.0f, value(rng) * 100.0f };
+		auto rotation = rl::Quaternion::fromEuler(value(rng), value(rng), value(rng));
+		auto handle = store.add(position, rotation, 4.0f, inertia);
+
+		Vector6f tau;
+		tau << value(rng), value(rng), value(rng), value(rng), value(rng), value(rng);
+		store.setTorque(handle, tau * 10.0f);
+		handles.push_back(handle);
+	}
+	return handles;
+}
+
+/**
+ * @brief Exact pose of a body moving for the time with constant body frame velocities.
+ * The rotation is q * exp(omega t), the position the integral of the rotated linear velocity.
+ */
+void exactPose(const rl::QuaternionD &q, const rl::Vec3<double> &p, const rl::Vec6<double> &nu, double t,
+	rl::QuaternionD &qOut, rl::Vec3<double> &pOut)
+{
+	rl::Vec3<double> v = nu.head<3>();
+	rl::Vec3<double> omega = nu.tail<3>();
+	double n = omega.norm();
+
+	rl::Vec3<double> integral = t * v;
+	if (n > 1e-12) {
+		integral += (1.0 - std::cos(n * t)) / (n * n) * omega.cross(v)
+			+ (t - std::sin(n * t) / n) / (n * n) * omega.cross(omega.cross(v));
+	}
+	qOut = q * rl::QuaternionD::fromRotationVector(omega * t);
+	pOut = p + q.rotateVector(integral);
+}
+
+/**
+ * @brief Measures the cost of a kinematics step of every integrator and its error after a simulated second
+ * against the exact solution, at time steps from the physics rate to a quarter of the frame rate.
+ */
+void benchIntegrators()
+{
+	constexpr size_t COUNT = 1'000;
+	constexpr double DURATION = 1.0;
+	const std::pair<rl::Integrator, const char *> integrators[] = {
+		{ rl::Integrator::Euler, "euler" },
+		{ rl::Integrator::SemiImplicitEuler, "semi-implicit" },
+		{ rl::Integrator::RungeKutta4, "rk4" },
+		{ rl::Integrator::Exponential, "exponential" },
+		{ rl::Integrator::RungeKutta45, "rk45" },
+	};
+	const int rates[] = { 240, 60, 15 };
+
+	// The state is in double precision, so the errors are those of the schemes and not of the rounding.
+	auto &store = rl::BodyStoreD::instance();
+	bench::header("rl::Integrator, kinematics of rl::BodyStoreD, errors after 1 s");
+
+	auto handles = spawn<double>(COUNT);
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+	std::vector<Vector3> positions;
+	std::vector<rl::Quaternion> rotations;
+	std::vector<Vector6f> torques;
+	for (auto handle : handles) {
+		positions.push_back(store.position(handle));
+		rotations.push_back(store.rotation(handle));
+		torques.emplace_back();
+		torques.back() << value(rng), value(rng), value(rng), value(rng), value(rng), value(rng);
+	}
+
+	for (const auto &[integrator, name] : integrators) {
+		store.setIntegrator(integrator);
+		for (int rate : rates) {
+			float dt = 1.0f / rate;
+			size_t steps = rate * DURATION;
+
+			for (size_t i = 0; i < COUNT; ++i) {
+				store.reset(handles[i], positions[i], rotations[i]);
+				store.setTorque(handles[i], torques[i]);
+			}
+			// Velocities of the magnitude of tau / m, up to a few rad/s.
+			store.rigidBody(0, COUNT, 1.0f);
+			for (size_t step = 0; step < steps; ++step) {
+				store.kinematics(0, COUNT, dt);
+			}
+
+			double positionError = 0.0;
+			double rotationError = 0.0;
+			for (size_t i = 0; i < COUNT; ++i) {
+				size_t idx = store.index(handles[i]);
+				rl::Vec6<double> nu;
+				for (int c = 0; c < 6; ++c) {
+					nu[c] = store.velocities(c)[idx];
+				}
+
+				rl::QuaternionD qExact(0, 0, 0, 1);
+				rl::Vec3<double> pExact;
+				exactPose(rotations[i].cast<double>().normalize(), rl::Vec3<double>(positions[i].x, positions[i].y, positions[i].z),
+					nu, steps * double(dt), qExact, pExact);
+
+				rl::Vec3<double> p(store.positions(0)[idx], store.positions(1)[idx], store.positions(2)[idx]);
+				rl::QuaternionD q(store.rotations(0)[idx], store.rotations(1)[idx], store.rotations(2)[idx],
+					store.rotations(3)[idx]);
+				rl::Vec3<double> difference = (qExact.cconjugate() * q).data().head<3>();
+
+				positionError = std::max(positionError, (p - pExact).norm());
+				rotationError = std::max(rotationError, 2.0 * std::asin(std::min(1.0, difference.norm())));
+			}
+
+			double ns = bench::run(std::format("{} 1/{}", name, rate), COUNT, [&]() { store.kinematics(0, COUNT, dt); });
+			std::println("{:<28} {:>10} {:>12.2f} ns per simulated second, position error {:.2e} m, rotation error {:.2e} rad",
+				"", "", ns * steps, positionError, rotationError);
+		}
+	}
+
+	store.setIntegrator(rl::Integrator::Euler);
+	for (auto handle : handles) {
+		store.remove(handle);
+	}
+}
+
+}
+
+void bench_body()
+{
+	auto &store = rl::BodyStore::instance();
+	bench::header("rl::BodyStore");
+
+	for (size_t batch : bench::BATCH_SIZES) {
+		auto handles = spawn(batch);
+
+		bench::run("rigidBody", batch, [&]() { store.rigidBody(0, batch, DT); });
+		bench::run("kinematics", batch, [&]() { store.kinematics(0, batch, DT); });
+		bench::run("integrate", batch, [&]() { store.integrate(DT); });
+
+		for (auto handle : handles) {
+			store.remove(handle);
+		}
+	}
+
+	benchIntegrators();
+}
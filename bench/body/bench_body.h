@@ -0,0 +1,5 @@
+#pragma once
+
+#include "body.h"
+
+void bench_body();
@@ -0,0 +1,7 @@
+#include "bench_body.h"
+#include "bench_quaternion.h"
+
+int main (int argc, char *argv[]) {
+	bench_quaternion();
+	bench_body();
+}
@@ -0,0 +1,148 @@
+#include "bench_quaternion.h"
+#include "bench.h"
+#include "batch.h"
+
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+struct Data
+{
+	explicit Data(size_t size)
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> angle(-PI, PI);
+		for (size_t i = 0; i < size; ++i) {
+			euler.emplace_back(angle(rng), angle(rng) / 2.0f, angle(rng));
+			lhs.push_back(rl::Quaternion::fromEuler(euler.back()));
+			rhs.push_back(rl::Quaternion::fromEuler(angle(rng), angle(rng) / 2.0f, angle(rng)));
+			vectors.emplace_back(angle(rng), angle(rng), angle(rng));
+		}
+		out = lhs;
+		scalars.resize(size);
+		matrices.resize(size);
+		eulerOut.resize(size);
+	}
+
+	std::vector<rl::Quaternion> lhs;
+	std::vector<rl::Quaternion> rhs;
+	std::vector<rl::Quaternion> out;
+	std::vector<Vector3f> euler;
+	std::vector<Vector3f> eulerOut;
+	std::vector<Vector3f> vectors;
+	std::vector<float> scalars;
+	std::vector<::Matrix> matrices;
+};
+
+/**
+ * @brief The same data in the structure-of-arrays layout of the batched kernels.
+ */
+struct BatchData
+{
+	explicit BatchData(const Data &data)
+	{
+		for (size_t i = 0; i < data.lhs.size(); ++i) {
+			for (int c = 0; c < 4; ++c) {
+				lhs[c].push_back(data.lhs[i].data()[c]);
+				rhs[c].push_back(data.rhs[i].data()[c]);
+			}
+			for (int c = 0; c < 3; ++c) {
+				vectors[c].push_back(data.vectors[i][c]);
+			}
+		}
+		out = lhs;
+		vectorsOut = vectors;
+		matrices.resize(data.lhs.size());
+	}
+
+	static rl::quatbatch::Quaternions span(std::array<std::vector<float>, 4> &q)
+	{
+		return { q[0].data(), q[1].data(), q[2].data(), q[3].data() };
+	}
+	static rl::quatbatch::Vectors span(std::array<std::vector<float>, 3> &v)
+	{
+		return { v[0].data(), v[1].data(), v[2].data() };
+	}
+
+	std::array<std::vector<float>, 4> lhs;
+	std::array<std::vector<float>, 4> rhs;
+	std::array<std::vector<float>, 4> out;
+	std::array<std::vector<float>, 3> vectors;
+	std::array<std::vector<float>, 3> vectorsOut;
+	std::vector<::Matrix> matrices;
+};
+
+/**
+ * @brief Measures the kernel at all the batch sizes, the kernel is called with the index of every element.
+ */
+template <typename Kernel>
+void measure(std::string_view name, Data &data, Kernel &&kernel)
+{
+	for (size_t batch : bench::BATCH_SIZES) {
+		bench::run(name, batch, [&]() {
+			for (size_t i = 0; i < batch; ++i) {
+				kernel(i);
+			}
+			bench::doNotOptimize(data.out.data());
+			bench::doNotOptimize(data.scalars.data());
+			bench::doNotOptimize(data.matrices.data());
+			bench::doNotOptimize(data.eulerOut.data());
+		});
+	}
+}
+
+}
+
+void bench_quaternion()
+{
+	Data d(bench::BATCH_SIZES.back());
+	bench::header("rl::Quaternion");
+
+	measure("operator+", d, [&](size_t i) { d.out[i] = d.lhs[i] + d.rhs[i]; });
+	measure("operator-", d, [&](size_t i) { d.out[i] = d.lhs[i] - d.rhs[i]; });
+	measure("operator*(q, q)", d, [&](size_t i) { d.out[i] = d.lhs[i] * d.rhs[i]; });
+	measure("operator*(q, s)", d, [&](size_t i) { d.out[i] = d.lhs[i] * 0.5; });
+	measure("operator*(s, q)", d, [&](size_t i) { d.out[i] = 0.5 * d.lhs[i]; });
+	measure("operator/", d, [&](size_t i) { d.out[i] = d.lhs[i] / d.rhs[i]; });
+	measure("operator&", d, [&](size_t i) { d.scalars[i] = d.lhs[i] & d.rhs[i]; });
+	measure("operator+=", d, [&](size_t i) { d.out[i] = d.lhs[i]; d.out[i] += d.rhs[i]; });
+	measure("operator-=", d, [&](size_t i) { d.out[i] = d.lhs[i]; d.out[i] -= d.rhs[i]; });
+	measure("operator*=(q)", d, [&](size_t i) { d.out[i] = d.lhs[i]; d.out[i] *= d.rhs[i]; });
+	measure("operator*=(s)", d, [&](size_t i) { d.out[i] = d.lhs[i]; d.out[i] *= 0.5f; });
+	measure("operator/=", d, [&](size_t i) { d.out[i] = d.lhs[i]; d.out[i] /= d.rhs[i]; });
+	measure("dot", d, [&](size_t i) { d.scalars[i] = d.lhs[i].dot(d.rhs[i]); });
+	measure("magnitude", d, [&](size_t i) { d.scalars[i] = d.lhs[i].magnitude(); });
+	measure("normalize", d, [&](size_t i) { d.out[i] = d.lhs[i]; d.out[i].normalize(); });
+	measure("cconjugate", d, [&](size_t i) { d.out[i] = d.lhs[i].cconjugate(); });
+	measure("rotate", d, [&](size_t i) { d.out[i] = d.lhs[i].rotate(d.vectors[i]); });
+	measure("slerp", d, [&](size_t i) { d.out[i] = rl::Quaternion::slerp(d.lhs[i], d.rhs[i], 0.5f); });
+	measure("fromEuler", d, [&](size_t i) { d.out[i] = rl::Quaternion::fromEuler(d.euler[i]); });
+	measure("toEuler", d, [&](size_t i) { d.eulerOut[i] = d.lhs[i].toEuler(); });
+	measure("toRlRotMatrix", d, [&](size_t i) { d.matrices[i] = d.lhs[i].toRlRotMatrix(); });
+
+	BatchData b(d);
+	auto lhs = BatchData::span(b.lhs), rhs = BatchData::span(b.rhs), out = BatchData::span(b.out);
+	auto vectors = BatchData::span(b.vectors), vectorsOut = BatchData::span(b.vectorsOut);
+	bench::header(rl::quatbatch::avx2() ? "rl::quatbatch (AVX2)" : "rl::quatbatch (scalar)");
+
+	// The batched kernels process the whole batch in a single call.
+	auto measureBatch = [&](std::string_view name, auto &&kernel) {
+		for (size_t batch : bench::BATCH_SIZES) {
+			bench::run(name, batch, [&]() {
+				kernel(batch);
+				bench::doNotOptimize(b.out[0].data());
+				bench::doNotOptimize(b.vectorsOut[0].data());
+				bench::doNotOptimize(b.matrices.data());
+			});
+		}
+	};
+
+	measureBatch("multiply", [&](size_t n) { rl::quatbatch::multiply(lhs, rhs, out, n); });
+	measureBatch("normalize", [&](size_t n) { rl::quatbatch::normalize(out, n); });
+	measureBatch("rotate(q[i], v[i])", [&](size_t n) { rl::quatbatch::rotate(lhs, vectors, vectorsOut, n); });
+	measureBatch("rotate(q, v[i])", [&](size_t n) { rl::quatbatch::rotate(d.lhs[0], vectors, vectorsOut, n); });
+	measureBatch("toMatrices", [&](size_t n) { rl::quatbatch::toMatrices(lhs, b.matrices.data(), n); });
+}
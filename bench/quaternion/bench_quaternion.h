@@ -0,0 +1,5 @@
+#pragma once
+
+#include "quaternion.h"
+
+void bench_quaternion();
@@ -0,0 +1,309 @@
+#include "app.h"
+
+#include "drone.h"
+#include "factory.h"
+#include "plane.h"
+#include "spaceship.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <sys/resource.h>
+
+using nlohmann::json;
+
+// Counts every heap allocation of the process.
+static std::atomic<size_t> allocations{ 0 };
+
+void *operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	size_t align = static_cast<size_t>(alignment);
+	if (void *ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace
+{
+
+struct Options
+{
+	// Copies spawned of every vehicle config.
+	size_t count = 1000;
+	// Distance of the grid points the copies are spread over, larger than the vehicles so they do not start piled up.
+	float spacing = 20.0f;
+	size_t steps = 2000;
+	// Steps run before the measurement, the scratch buffers of the passes grow to their working size during them.
+	size_t warmup = 240;
+	float dt = 1.0f / 240.0f;
+	// Scheme of the kinematics, higher order ones hold the accuracy at larger steps.
+	rl::Integrator integrator = rl::Integrator::Euler;
+	// Allowed relative regression against the baseline.
+	double threshold = 0.1;
+	// Record the results as the new baseline instead of comparing against it.
+	bool record = false;
+	std::filesystem::path baseline = BASELINE_PATH;
+	std::filesystem::path output;
+	// Chrome trace of the run, not written when empty.
+	std::filesystem::path trace;
+};
+
+struct Result
+{
+	size_t objects;
+	size_t steps;
+	double seconds;
+	double stepsPerSecond;
+	double bodyStepsPerSecond;
+	size_t allocations;
+	long peakRssKb;
+};
+
+Options parse(int argc, char *argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		std::string_view arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--count" && hasValue) options.count = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--spacing" && hasValue) options.spacing = std::strtof(argv[++i], nullptr);
+		else if (arg == "--steps" && hasValue) options.steps = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--warmup" && hasValue) options.warmup = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--dt" && hasValue) options.dt = std::strtof(argv[++i], nullptr);
+		else if (arg == "--integrator" && hasValue) options.integrator = rl::integratorFromName(argv[++i]);
+		else if (arg == "--threshold" && hasValue) options.threshold = std::strtod(argv[++i], nullptr);
+		else if (arg == "--baseline" && hasValue) options.baseline = argv[++i];
+		else if (arg == "--output" && hasValue) options.output = argv[++i];
+		else if (arg == "--trace" && hasValue) options.trace = argv[++i];
+		else if (arg == "--record") options.record = true;
+		else {
+			std::println("Usage: {} [--count N] [--spacing M] [--steps N] [--warmup N] [--dt S] [--integrator NAME] [--threshold R] [--baseline FILE] "
+				"[--output FILE] [--trace FILE] [--record]", argv[0]);
+			std::exit(2);
+		}
+	}
+	return options;
+}
+
+/**
+ * @brief Scripted input replayed by every run, exercises all the thrust and moment axes.
+ */
+rl::InputScript script()
+{
+	rl::InputScript script;
+	script.hold(240, { KEY_UP, KEY_W })
+		.hold(240, { KEY_LEFT, KEY_Q })
+		.hold(240, { KEY_A })
+		.hold(240, { KEY_DOWN, KEY_S, KEY_E })
+		.hold(240, {});
+	return script;
+}
+
+Result run(const Options &options)
+{
+	rl::Application::Config config{
+		.fps = 60,
+		.monitor = 0,
+		.screenHeight = 0,
+		.screenWidth = 0,
+		.windowTitle = "bench_scenario",
+		.camera = nullptr,
+		.integrator = options.integrator,
+		.tracePath = options.trace.string(),
+	};
+	rl::Application app(config);
+
+	// Vehicle types are registered by the name of their config file in the resources directory.
+	auto &factory = rl::ObjectFactory::instance();
+	factory.add<Drone>("drone");
+	factory.add<Plane>("plane");
+	factory.add<Spaceship>("spaceship");
+
+	std::vector<std::pair<std::string, rl::Model>> vehicles;
+	for (const auto &entry : std::filesystem::directory_iterator(RESOURCES_PATH)) {
+		if (entry.path().extension() != ".json") {
+			continue;
+		}
+
+		auto type = entry.path().stem().string();
+		if (!factory.contains(type)) {
+			std::println("[Warning]: Unknown vehicle config: {}", entry.path().string());
+			continue;
+		}
+		vehicles.emplace_back(type, rl::Model::fromFile(entry.path()));
+	}
+
+	// All the copies share one cubic grid centered above the origin. The points are jittered by a quarter of the
+	// spacing with a fixed seed, so the scene is irregular but the same in every run.
+	size_t total = vehicles.size() * options.count;
+	size_t side = std::max<size_t>(1, std::ceil(std::cbrt(double(total))));
+	float half = 0.5f * (side - 1) * options.spacing;
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> jitter(-0.25f * options.spacing, 0.25f * options.spacing);
+
+	size_t placed = 0;
+	for (auto &[type, model] : vehicles) {
+		factory.reserve(type, options.count);
+		std::vector<rl::Object::Ptr> objects;
+		objects.reserve(options.count);
+		for (size_t i = 0; i < options.count; ++i, ++placed) {
+			size_t x = placed % side;
+			size_t y = placed / side % side;
+			size_t z = placed / (side * side);
+			model.position = Vector3{
+				x * options.spacing - half + jitter(generator),
+				y * options.spacing + jitter(generator),
+				z * options.spacing - half + jitter(generator),
+			};
+			objects.push_back(factory.create(type, model));
+		}
+		app.addObjects(std::move(objects));
+	}
+
+	auto input = script();
+	app.runHeadless(options.warmup, options.dt, input);
+
+	size_t allocationsBefore = allocations.load();
+	auto stats = app.runHeadless(options.steps, options.dt, input);
+
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+
+	return Result{
+		.objects = stats.objects,
+		.steps = stats.steps,
+		.seconds = stats.seconds,
+		.stepsPerSecond = stats.stepsPerSecond,
+		.bodyStepsPerSecond = stats.bodyStepsPerSecond,
+		.allocations = allocations.load() - allocationsBefore,
+		.peakRssKb = usage.ru_maxrss,
+	};
+}
+
+json toJson(const Result &result)
+{
+	return json{
+		{ "objects", result.objects },
+		{ "steps", result.steps },
+		{ "seconds", result.seconds },
+		{ "stepsPerSecond", result.stepsPerSecond },
+		{ "bodyStepsPerSecond", result.bodyStepsPerSecond },
+		{ "allocations", result.allocations },
+		{ "peakRssKb", result.peakRssKb },
+	};
+}
+
+/**
+ * @brief Compares the result with the baseline, returns false if any metric regressed past the threshold.
+ */
+bool compare(const Result &result, const json &baseline, double threshold)
+{
+	if (baseline.value("objects", size_t(0)) != result.objects || baseline.value("steps", size_t(0)) != result.steps) {
+		std::println("[Warning]: Baseline was recorded with {} objects and {} steps, not comparing",
+			baseline.value("objects", size_t(0)), baseline.value("steps", size_t(0)));
+		return true;
+	}
+
+	bool passed = true;
+	auto check = [&](std::string_view metric, double value, double reference, bool higherIsBetter) {
+		// Anything above a zero baseline, e.g. allocations in an allocation free loop, counts as a full regression.
+		double change = reference == 0.0 ? (value == 0.0 ? 0.0 : 1.0) : (value - reference) / reference;
+		bool regressed = higherIsBetter ? change < -threshold : change > threshold;
+		std::println("{:<20} {:>16.2f} baseline {:>16.2f} ({:+.1f} %){}", metric, value, reference, change * 100.0,
+			regressed ? " REGRESSION" : "");
+		passed &= !regressed;
+	};
+
+	check("bodyStepsPerSecond", result.bodyStepsPerSecond, baseline.value("bodyStepsPerSecond", 0.0), true);
+	check("allocations", result.allocations, baseline.value("allocations", 0.0), false);
+	check("peakRssKb", result.peakRssKb, baseline.value("peakRssKb", 0.0), false);
+	return passed;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	Options options = parse(argc, argv);
+	Result result = run(options);
+
+	std::println("\nScenario: {} objects, {} steps of {} s", result.objects, result.steps, options.dt);
+	std::println("Wall time: {:.3f} s", result.seconds);
+	std::println("Steps/s: {:.0f}", result.stepsPerSecond);
+	std::println("Body-steps/s: {:.0f}", result.bodyStepsPerSecond);
+	std::println("Allocations during the run: {}", result.allocations);
+	std::println("Peak RSS: {} KiB", result.peakRssKb);
+
+	json results = toJson(result);
+	if (!options.output.empty()) {
+		std::ofstream(options.output) << results.dump(4) << std::endl;
+	}
+
+	// The step loop has to be allocation free whatever the baseline says. Tracing records its events on the heap.
+	if (options.trace.empty() && result.allocations != 0) {
+		std::println("[Error]: {} allocations after the warmup, the steps have to be allocation free", result.allocations);
+		return 1;
+	}
+
+	if (options.record) {
+		std::ofstream(options.baseline) << results.dump(4) << std::endl;
+		std::println("Recorded baseline: {}", options.baseline.string());
+		return 0;
+	}
+
+	std::ifstream file(options.baseline);
+	if (!file.is_open()) {
+		std::println("[Warning]: No baseline at {}, record one with --record", options.baseline.string());
+		return 0;
+	}
+
+	if (!compare(result, json::parse(file), options.threshold)) {
+		std::println("[Error]: Performance regressed more than {:.0f} % against the baseline", options.threshold * 100.0);
+		return 1;
+	}
+	return 0;
+}
@@ -1,11 +1,46 @@
 #include "app.h"
 
+#include <cstdlib>
+#include <print>
+#include <string>
+#include <string_view>
+
 #include "drone.h"
+#include "factory.h"
 #include "plane.h"
+#include "scenario.h"
 #include "spaceship.h"
 
-int main(void)
+int main(int argc, char *argv[])
 {
+	// Usage: first [--scenario <file>] [--headless <steps> <dt>] [--trace <file>]
+	rl::Path scenarioPath = RESOURCES_PATH "/scenarios/default.json";
+	bool headless = false;
+	size_t steps = 100000;
+	float dt = 1.0f / 60.0f;
+	std::string tracePath;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string_view arg = argv[i];
+		if (arg == "--scenario" && i + 1 < argc) {
+			scenarioPath = argv[++i];
+		}
+		else if (arg == "--headless") {
+			headless = true;
+			steps = i + 1 < argc ? std::strtoull(argv[++i], nullptr, 10) : steps;
+			dt = i + 1 < argc ? std::strtof(argv[++i], nullptr) : dt;
+		}
+		else if (arg == "--trace" && i + 1 < argc) {
+			tracePath = argv[++i];
+		}
+		else {
+			std::println("Usage: {} [--scenario <file>] [--headless <steps> <dt>] [--trace <file>]", argv[0]);
+			return 2;
+		}
+	}
+
+	auto scenario = rl::Scenario::fromFile(scenarioPath);
+
 	rl::Application::Config config{
 		.fps = 60,
 		.monitor = 1,
@@ -13,15 +48,30 @@ int main(void)
 		.screenWidth = 800,
 		.windowTitle = "Raylib App",
 		.camera = nullptr,
+		.physicsRate = 240.0f,
+		.precision = scenario.precision(),
+		.integrator = scenario.integrator(),
+		.tracePath = tracePath,
 	};
 
 	rl::Application app(config);
 
-	app.addObject(Plane::create(rl::Model::fromFile(PLANE_CONFIG_PATH)));
-	app.addObject(Drone::create(rl::Model::fromFile(DRONE_CONFIG_PATH)));
-	app.addObject(Spaceship::create(rl::Model::fromFile(SPACESHIP_CONFIG_PATH)));
+	auto &factory = rl::ObjectFactory::instance();
+	factory.add<Plane>("plane");
+	factory.add<Drone>("drone");
+	factory.add<Spaceship>("spaceship");
+
+	app.addObjects(scenario.instantiate());
 
-	app.run();
+	if (headless) {
+		std::println("Running {} headless steps of {} s with {} objects", steps, dt, scenario.size());
+		auto stats = app.runHeadless(steps, dt);
+		std::println("Headless run finished in {:.3f} s: {:.0f} steps/s, {:.0f} body-steps/s",
+			stats.seconds, stats.stepsPerSecond, stats.bodyStepsPerSecond);
+	}
+	else {
+		app.run();
+	}
 
 	return 0;
 }
@@ -1,13 +1,30 @@
 #include "app.h"
 
 #include <algorithm>
-#include <execution>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <set>
 #include <raylib.h>
 #include <raymath.h>
 #include <rcamera.h>
 #include <print>
 
+#include "batch.h"
+#include "factory.h"
+#include "meshcache.h"
+#include "trace.h"
+
 constexpr Vector3 CAMERA_DEFAULT_POSITION{ 0.0f, 5.0f, -15.0f };
+// Number of objects handled by a single job of the parallel passes.
+constexpr size_t UPDATE_GRAIN = 256;
+constexpr size_t INTEGRATE_GRAIN = 4096;
+constexpr size_t INTERPOLATE_GRAIN = 1024;
+// Layout of the HUD panel in pixels.
+constexpr int HUD_MARGIN = 10;
+constexpr int HUD_PADDING = 10;
+constexpr int HUD_FONT_SIZE = 10;
 
 namespace rl
 {
@@ -42,17 +59,109 @@ Application::Application(const Config& config)
 		m_camera = *m_config.camera;
 	}
 
+	// Use default values if the physics clock is not configured.
+	if (m_config.physicsRate <= 0.0f) {
+		m_config.physicsRate = 240.0f;
+	}
+	if (m_config.maxFrameTime <= 0.0f) {
+		m_config.maxFrameTime = 0.25f;
+	}
+	m_physicsDt = 1.0f / m_config.physicsRate;
+	rl::BodyStore::instance().setIntegrator(m_config.integrator);
+	rl::BodyStoreD::instance().setIntegrator(m_config.integrator);
+	// The speeds stay those of the variable frame loop the controllers were tuned with, whatever the physics rate.
+	rl::BodyStore::instance().setResponseTime(1.0f / rl::CONTROL_RATE);
+	rl::BodyStoreD::instance().setResponseTime(1.0f / rl::CONTROL_RATE);
+
+	rl::ImageLoader::instance().setTextureSettings(m_config.textures);
+
 	m_config.onInit(*this);
 }
 
-void rl::Application::addObject(rl::Object::Ptr model)
+rl::PoolHandle rl::Application::addObject(rl::Object::Ptr model)
 {
-	m_objects.push_back(model);
+	auto &entries = rl::Pool<Entry>::instance();
+	Entry *entry = entries.create(Entry{ .object = m_objects.size(), .lane = 0, .slot = 0 });
+	rl::PoolHandle handle = entries.handle(entry);
+
+	addToLane(*entry, model, handle);
+	m_objects.push_back(std::move(model));
+	m_handles.push_back(handle);
+	return handle;
+}
+
+std::vector<rl::PoolHandle> Application::addObjects(std::vector<rl::Object::Ptr> objects)
+{
+	m_objects.reserve(m_objects.size() + objects.size());
+	m_handles.reserve(m_handles.size() + objects.size());
+	auto &entries = rl::Pool<Entry>::instance();
+	entries.reserve(entries.size() + objects.size());
+
+	std::vector<rl::PoolHandle> handles;
+	handles.reserve(objects.size());
+	for (auto &object : objects) {
+		handles.push_back(addObject(std::move(object)));
+	}
+	return handles;
+}
+
+bool Application::removeObject(rl::PoolHandle handle)
+{
+	auto &entries = rl::Pool<Entry>::instance();
+	Entry *entry = entries.get(handle);
+	if (!entry) {
+		std::println("[Warning]: The object of the handle {}:{} was already removed", handle.index, handle.generation);
+		return false;
+	}
+
+	// The last object of the lane and the last object of the application move into the freed places.
+	if (Entry *moved = entries.get(m_lanes[entry->lane]->remove(entry->slot))) {
+		moved->slot = entry->slot;
+	}
+
+	size_t last = m_objects.size() - 1;
+	rl::Object::Ptr removed = std::move(m_objects[entry->object]);
+	if (entry->object != last) {
+		m_objects[entry->object] = std::move(m_objects[last]);
+		m_handles[entry->object] = m_handles[last];
+		entries.get(m_handles[entry->object])->object = entry->object;
+	}
+	m_objects.pop_back();
+	m_handles.pop_back();
+
+	// The camera keeps following its object if it was the one moved, otherwise it falls back to the first object.
+	if (m_followed == last) {
+		m_followed = entry->object;
+	}
+	if (m_followed >= m_objects.size()) {
+		m_followed = 0;
+	}
+
+	// The handle turns stale, the streaming list drops it once it sees it.
+	entries.destroy(entry);
+	return true;
+}
+
+rl::Object *Application::object(rl::PoolHandle handle) const
+{
+	const Entry *entry = rl::Pool<Entry>::instance().get(handle);
+	return entry ? m_objects[entry->object].get() : nullptr;
+}
+
+void Application::addToLane(Entry &entry, const rl::Object::Ptr &object, rl::PoolHandle handle)
+{
+	LaneKey key{ typeid(*object), object->precision() };
+	auto it = m_laneIndex.find(key);
+	if (it == m_laneIndex.end()) {
+		m_lanes.push_back(rl::ObjectFactory::instance().lane(key.first, key.second));
+		it = m_laneIndex.emplace(key, m_lanes.size() - 1).first;
+	}
+	entry.lane = it->second;
+	entry.slot = m_lanes[it->second]->add(object.get(), handle);
 }
 
 void Application::run()
 {
-	static uint8_t idx = 0;
 	SetWindowMonitor(m_config.monitor);
 	InitWindow(m_config.screenWidth, m_config.screenHeight, m_config.windowTitle.c_str());
 
@@ -63,67 +172,402 @@ void Application::run()
 
 	UpdateCamera(&m_camera, CAMERA_CUSTOM);
 
-	for (auto object : m_objects) {
-		object->loadModel();
+	// The models are parsed in the background and uploaded a few per frame, the objects are drawn
+	// as placeholders until then.
+	{
+		RL_TRACE_SCOPE("preloadModels");
+		auto &loader = rl::ImageLoader::instance();
+		for (size_t i = 0; i < m_objects.size(); ++i) {
+			loader.preload(m_objects[i]->rlModel(), m_streaming);
+			m_loading.push_back(m_handles[i]);
+		}
 	}
 
-	std::println("Loaded {} objects", m_objects.size());
-	auto rotate = [this](const Object::Ptr object, const Vector3 &rotation) {
-		return object->rotation().rotate(rotation).toRlVector3();
+	std::println("Streaming {} objects", m_objects.size());
+
+	if (m_config.hotReload) {
+		watchFiles();
+	}
+	auto rotate = [](const Object::Ptr &object, const Vector3 &rotation) {
+		return object->renderRotation().rotate(rotation).toRlVector3();
 	};
 
 	while (!WindowShouldClose())
 	{
-		if (IsKeyDown(KEY_ESCAPE)) {
+		RL_TRACE_SCOPE("frame");
+		m_frameStats.push(GetFrameTime());
+
+		// The keyboard is polled once per frame, every physics step of the frame sees the same input.
+		const InputState input = InputState::sample();
+
+		if (input.down(KEY_ESCAPE)) {
 			CloseWindow();
 			return;
 		}
 
-		if (IsKeyPressed(KEY_I)) {
-			idx = (idx + 1) % m_objects.size();
-			std::println("Current object index: {}", idx);
+		if (input.pressed(KEY_I) && !m_objects.empty()) {
+			m_followed = (m_followed + 1) % m_objects.size();
+			std::println("Current object index: {}", m_followed);
+		}
+
+		stream();
+		applyReloads();
+
+		// Physics advances in fixed steps independent of the frame rate. The frame time is clamped
+		// so a long hitch does not make the simulation spiral into more and more catch-up steps.
+		m_accumulator += std::min(GetFrameTime(), m_config.maxFrameTime);
+		while (m_accumulator >= m_physicsDt) {
+			step(m_physicsDt, input);
+			m_accumulator -= m_physicsDt;
+		}
+
+		// Render the objects between the last two physics states.
+		float alpha = m_accumulator / m_physicsDt;
+		{
+			RL_TRACE_SCOPE("interpolate");
+			interpolate(alpha);
 		}
 
+		RL_TRACE_SCOPE("render");
 		BeginDrawing();
 			ClearBackground(RAYWHITE);
 
-			const auto &model = m_objects[idx]->rlModel();
-			m_camera.target = model.position + rotate(m_objects[idx], Vector3{0.0f, 1.0f, 0.0f});
-			m_camera.position = m_camera.target + rotate(m_objects[idx], model.camera.offset);
-			m_camera.up = rotate(m_objects[idx], model.camera.up);
+			// Without objects the camera stays where it is.
+			if (!m_objects.empty()) {
+				const auto &followed = m_objects[m_followed];
+				const auto &model = followed->rlModel();
+				m_camera.target = followed->renderPosition() + rotate(followed, Vector3{0.0f, 1.0f, 0.0f});
+				m_camera.position = m_camera.target + rotate(followed, model.camera.offset);
+				m_camera.up = rotate(followed, model.camera.up);
+			}
 
 			BeginMode3D(m_camera);
 
-			DrawGrid(100, 1.0f);
-
-			float dt = GetFrameTime();
-			std::for_each(std::execution::par, m_objects.begin(), m_objects.end(), [this, &dt](Object::Ptr object) {
-				object->update(dt);
-			});
+			{
+				RL_TRACE_SCOPE("DrawGrid");
+				DrawGrid(100, 1.0f);
+			}
 
-			std::for_each(m_objects.begin(), m_objects.end(), [this, &dt](Object::Ptr object) {
-				object->draw();
-			});
+			{
+				RL_TRACE_SCOPE("draw");
+				std::for_each(m_objects.begin(), m_objects.end(), [](const Object::Ptr &object) {
+					object->draw();
+				});
+			}
 
 			EndMode3D();
 
-			DrawRectangle(10, 10, 250, 113, Fade(SKYBLUE, 0.5));
-			DrawRectangleLines( 10, 10, 250, 113, BLUE);
+			if (!m_objects.empty()) {
+				RL_TRACE_SCOPE("hud");
+				const auto &p = m_objects[0]->renderPosition();
+				const auto &q = m_objects[0]->renderRotation().toEuler(true);
+				const char *blocks[] = {
+					TextFormat("Position:\n %10.2f\n %10.2f\n %10.2f", p.x, p.y, p.z),
+					TextFormat("Rotation:\n %10.2f\n %10.2f\n %10.2f", q(0), q(1), q(2)),
+					TextFormat("Frame time [ms]:\n p50 %6.2f\n p95 %6.2f\n p99 %6.2f",
+						m_frameStats.percentile(50) * 1000.0f, m_frameStats.percentile(95) * 1000.0f,
+						m_frameStats.percentile(99) * 1000.0f),
+				};
+
+				// The panel is sized to the text, the blocks are stacked one font size apart.
+				Vector2 extents[std::size(blocks)];
+				int width = 0;
+				int height = -HUD_FONT_SIZE;
+				for (size_t i = 0; i < std::size(blocks); ++i) {
+					extents[i] = MeasureTextEx(GetFontDefault(), blocks[i], HUD_FONT_SIZE, HUD_FONT_SIZE / 10.0f);
+					width = std::max(width, int(std::ceil(extents[i].x)));
+					height += int(std::ceil(extents[i].y)) + HUD_FONT_SIZE;
+				}
+
+				int panelSize[2] = { width + 2 * HUD_PADDING, height + 2 * HUD_PADDING };
+				DrawRectangle(HUD_MARGIN, HUD_MARGIN, panelSize[0], panelSize[1], Fade(SKYBLUE, 0.5));
+				DrawRectangleLines(HUD_MARGIN, HUD_MARGIN, panelSize[0], panelSize[1], BLUE);
 
-			const auto &p = m_objects[0]->rlModel().position;
-			const auto &q = m_objects[0]->rotation().toEuler(true);
-			DrawText(TextFormat("Position:\n %10.2f\n %10.2f\n %10.2f", p.x, p.y, p.z), 20, 20, 10, BLACK);
-			DrawText(TextFormat("Rotation:\n %10.2f\n %10.2f\n %10.2f", q(0), q(1), q(2)), 20, 70, 10, BLACK);
+				int y = HUD_MARGIN + HUD_PADDING;
+				for (size_t i = 0; i < std::size(blocks); ++i) {
+					DrawText(blocks[i], HUD_MARGIN + HUD_PADDING, y, HUD_FONT_SIZE, BLACK);
+					y += int(std::ceil(extents[i].y)) + HUD_FONT_SIZE;
+				}
+			}
 
 		EndDrawing();
 	}
 }
 
+Application::HeadlessStats Application::runHeadless(size_t steps, float dt, const InputScript &script)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < steps; ++i) {
+		step(dt, script.at(i));
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	HeadlessStats stats{
+		.steps = steps,
+		.objects = m_objects.size(),
+		.seconds = elapsed.count(),
+		.stepsPerSecond = 0.0,
+		.bodyStepsPerSecond = 0.0,
+	};
+	if (stats.seconds > 0.0) {
+		stats.stepsPerSecond = steps / stats.seconds;
+		stats.bodyStepsPerSecond = steps * m_objects.size() / stats.seconds;
+	}
+	return stats;
+}
+
+void Application::stream()
+{
+	if (m_loading.empty()) {
+		return;
+	}
+
+	RL_TRACE_SCOPE("stream");
+	auto &loader = rl::ImageLoader::instance();
+	size_t pending = loader.uploadPending(std::chrono::duration<float>(m_config.uploadBudget));
+	std::erase_if(m_loading, [this, &loader, pending](rl::PoolHandle handle) {
+		// Objects removed while their model was streaming in are dropped.
+		rl::Object *object = this->object(handle);
+		if (!object) {
+			return true;
+		}
+
+		// Once nothing is pending the remaining models failed to load in the background,
+		// loadModel reports the error.
+		if (pending > 0 && !loader.isLoaded(object->rlModel())) {
+			return false;
+		}
+		object->loadModel();
+		return true;
+	});
+
+	if (m_loading.empty()) {
+		std::println("Loaded {} objects, textures take {} KiB", m_objects.size(), loader.textureMemory() / 1024);
+	}
+}
+
+void Application::watchFiles()
+{
+	m_watcher = std::make_unique<rl::FileWatcher>([this](const std::filesystem::path &path) {
+		fileChanged(path);
+	});
+
+	// Thousands of objects share a handful of files.
+	std::set<std::string> files;
+	for (const auto &object : m_objects) {
+		const auto &model = object->rlModel();
+		for (const auto &file : { model.configPath, model.modelPath, model.texturePath }) {
+			if (!file.empty() && files.insert(file).second) {
+				m_watcher->watch(file);
+			}
+		}
+	}
+	std::println("Watching {} files for changes", files.size());
+}
+
+void Application::fileChanged(const std::filesystem::path &path)
+{
+	Reload reload{ .path = path, .config = std::nullopt };
+	if (path.extension() == ".json") {
+		try {
+			reload.config = rl::Model::fromFile(path);
+		}
+		catch (const std::exception &error) {
+			// A half edited file is reported again once it is saved in a valid state.
+			std::println("[Error]: Cannot reload {}: {}", path.string(), error.what());
+			return;
+		}
+	}
+
+	std::lock_guard lock(m_reloadMutex);
+	m_reloads.push_back(std::move(reload));
+}
+
+void Application::applyReloads()
+{
+	std::vector<Reload> reloads;
+	{
+		std::lock_guard lock(m_reloadMutex);
+		reloads.swap(m_reloads);
+	}
+	if (reloads.empty()) {
+		return;
+	}
+
+	RL_TRACE_SCOPE("reload");
+
+	// The watcher reports canonical paths, the objects hold the paths as configured.
+	std::map<std::string, std::filesystem::path> canonical;
+	auto matches = [&canonical](const std::string &file, const std::filesystem::path &path) {
+		if (file.empty()) {
+			return false;
+		}
+		auto it = canonical.find(file);
+		if (it == canonical.end()) {
+			std::error_code error;
+			it = canonical.emplace(file, std::filesystem::weakly_canonical(file, error)).first;
+		}
+		return it->second == path;
+	};
+
+	auto &loader = rl::ImageLoader::instance();
+	for (const auto &reload : reloads) {
+		auto start = std::chrono::steady_clock::now();
+		std::vector<rl::Object *> affected;
+		for (const auto &object : m_objects) {
+			const auto &model = object->rlModel();
+			bool uses = reload.config
+				? matches(model.configPath, reload.path)
+				: matches(model.modelPath, reload.path) || matches(model.texturePath, reload.path);
+			if (uses) {
+				affected.push_back(object.get());
+			}
+		}
+
+		if (reload.config) {
+			for (const auto &object : affected) {
+				object->reconfigure(*reload.config);
+			}
+			// The configuration may point to other files now.
+			if (!affected.empty() && m_watcher) {
+				for (const auto &file : { reload.config->modelPath, reload.config->texturePath }) {
+					if (!file.empty()) {
+						m_watcher->watch(file);
+					}
+				}
+			}
+		}
+		else {
+			// All the stale models are dropped first, so the changed file is loaded once and shared again.
+			for (const auto &object : affected) {
+				loader.evict(object->rlModel());
+			}
+
+			// The mass properties of the changed mesh are integrated once for all the objects using it.
+			std::optional<rl::MassProperties> properties;
+			bool integrated = false;
+			for (const auto &object : affected) {
+				object->loadModel();
+
+				const auto &model = object->rlModel();
+				if (!model.inertiaFromMesh || !matches(model.modelPath, reload.path)) {
+					continue;
+				}
+				if (!integrated) {
+					properties = rl::meshcache::massProperties(model.modelPath);
+					integrated = true;
+				}
+				if (properties && properties->volume > 0.0f) {
+					rl::Model updated = model;
+					updated.inertia = properties->inertiaFor(model.mass, model.scale);
+					object->reconfigure(updated);
+				}
+			}
+		}
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		std::println("Reloaded {} for {} objects in {:.2f} ms", reload.path.string(), affected.size(), elapsed.count());
+	}
+}
+
+void Application::interpolate(float alpha)
+{
+	size_t count = m_objects.size();
+	for (auto &component : m_renderRotations) {
+		component.resize(count);
+	}
+	m_renderTransforms.resize(count);
+
+	m_jobs.parallelFor(0, count, INTERPOLATE_GRAIN, [this, alpha](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			m_objects[i]->interpolate(alpha);
+			rl::Quaternion q = m_objects[i]->renderRotation();
+			m_renderRotations[0][i] = q.x();
+			m_renderRotations[1][i] = q.y();
+			m_renderRotations[2][i] = q.z();
+			m_renderRotations[3][i] = q.w();
+		}
+
+		// The rotation matrices of the whole range are computed at once, eight per AVX2 register.
+		rl::quatbatch::ConstQuaternions rotations{
+			m_renderRotations[0].data() + begin,
+			m_renderRotations[1].data() + begin,
+			m_renderRotations[2].data() + begin,
+			m_renderRotations[3].data() + begin,
+		};
+		rl::quatbatch::toMatrices(rotations, m_renderTransforms.data() + begin, end - begin);
+
+		for (size_t i = begin; i < end; ++i) {
+			m_objects[i]->transform(m_renderTransforms[i]);
+		}
+	});
+}
+
+void Application::step(float dt, const InputState &input)
+{
+	RL_TRACE_SCOPE("step");
+	// Every lane updates the objects of a single type and precision, their controllers are called without the virtual
+	// dispatch and their torques are set in the body store of the lane. The controller scaling is shared by all of them.
+	const rl::ControlStep control = rl::ControlStep::at(dt);
+	for (auto &lane : m_lanes) {
+		m_jobs.parallelFor(0, lane->size(), UPDATE_GRAIN, [&lane, &input, &control](size_t begin, size_t end) {
+			RL_TRACE_SCOPE("update");
+			lane->update(begin, end, input, control);
+		});
+	}
+
+	// The objects of a scenario share one precision, the store of the other one is usually empty.
+	auto integrate = [this, dt](auto &store) {
+		if (store.size() == 0) {
+			return;
+		}
+		m_jobs.parallelFor(0, store.size(), INTEGRATE_GRAIN, [&store, dt](size_t begin, size_t end) {
+			RL_TRACE_SCOPE("integrate");
+			store.integrate(begin, end, dt);
+		});
+	};
+	integrate(rl::BodyStore::instance());
+	integrate(rl::BodyStoreD::instance());
+
+	// The handles of the stores overlap, the collisions are only handled between the bodies of one precision.
+	rl::withBodyStore(m_config.precision, [this, dt](auto &store) {
+		m_broadphase.update(store, m_jobs);
+		m_narrowphase.update(store, m_broadphase.pairs(), m_jobs);
+		m_narrowphase.resolve(store, dt);
+	});
+}
+
+const std::vector<rl::Broadphase::Pair> &Application::collisionPairs() const
+{
+	return m_broadphase.pairs();
+}
+
+std::vector<rl::BodyStore::Handle> Application::queryBox(const BoundingBox &box) const
+{
+	return m_broadphase.query(box);
+}
+
+const std::vector<rl::Contact> &Application::contacts() const
+{
+	return m_narrowphase.contacts();
+}
+
 Application::~Application()
 {
 	m_config.onDeinit(*this);
 
-	CloseWindow();
+	for (rl::PoolHandle handle : m_handles) {
+		rl::Pool<Entry>::instance().destroy(rl::Pool<Entry>::instance().get(handle));
+	}
+
+	if (!m_config.tracePath.empty()) {
+		rl::trace::dump(m_config.tracePath);
+	}
+
+	// Headless runs never open a window.
+	if (IsWindowReady()) {
+		CloseWindow();
+	}
 }
 
 }
@@ -1,12 +1,27 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <filesystem>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <raylib.h>
 #include <string>
+#include <typeindex>
+#include <utility>
 #include <vector>
 
+#include "broadphase.h"
+#include "input.h"
+#include "jobs.h"
+#include "lane.h"
+#include "narrowphase.h"
 #include "object.h"
+#include "trace.h"
+#include "watcher.h"
 
 namespace rl
 {
@@ -46,6 +61,22 @@ public:
 		std::pair<int, int> windowPosition;
 		// Camera to be used in the application.
 		::Camera *camera = nullptr;
+		// Fixed rate of the physics steps in Hz, independent of the frame rate.
+		float physicsRate = 240.0f;
+		// Precision of the bodies the collisions are detected and resolved between, see rl::Scenario::precision.
+		rl::Precision precision = rl::Precision::Float;
+		// Scheme the poses of the bodies are integrated with, see rl::Scenario::integrator.
+		rl::Integrator integrator = rl::Integrator::Euler;
+		// Longest frame time in seconds the physics catches up with in a single frame.
+		float maxFrameTime = 0.25f;
+		// Path of the Chrome trace file written when the application exits, empty to not write any.
+		std::string tracePath;
+		// Time in seconds a frame spends at most uploading the models streamed in by the background loads.
+		float uploadBudget = 0.004f;
+		// Maximal size, mipmaps and pixel format of the loaded textures.
+		rl::TextureSettings textures;
+		// Watches the configuration and asset files of the objects and applies their changes while running.
+		bool hotReload = true;
 	};
 
 	/**
@@ -61,21 +92,181 @@ public:
 	 * This function needs to be called before running the application.
 	 * It allows the application to manage and render multiple 3D objects.
 	 *
-	 * @param model Smart pointer to the object model to be added.
+	 * @param model Owning pointer of the object to be added, the application takes over the object.
+	 * @return rl::PoolHandle Generational handle of the object, it turns stale once the object is removed.
 	 */
-	void addObject(const rl::Object::Ptr model);
+	rl::PoolHandle addObject(rl::Object::Ptr model);
+	/**
+	 * @brief Adds objects in bulk, e.g. the objects spawned by a rl::Scenario.
+	 * The storage is reserved once for all of them.
+	 *
+	 * @param objects Objects to be added.
+	 * @return std::vector<rl::PoolHandle> Handles of the objects, in their order.
+	 */
+	std::vector<rl::PoolHandle> addObjects(std::vector<rl::Object::Ptr> objects);
+	/**
+	 * @brief Removes the object from its update lane and destroys it, its body leaves the body store.
+	 * Takes constant time, the last object of the application and of the lane move into the freed places.
+	 *
+	 * @param handle Handle of the object to be removed.
+	 * @return bool False if the handle is stale, the object it referred to was already removed.
+	 */
+	bool removeObject(rl::PoolHandle handle);
+	/**
+	 * @brief Returns the object of the handle, nullptr if it was removed.
+	 */
+	rl::Object *object(rl::PoolHandle handle) const;
+
+	/**
+	 * @class HeadlessStats
+	 * @brief Timing report of a headless simulation run.
+	 */
+	struct HeadlessStats
+	{
+		// Number of simulation steps that were executed.
+		size_t steps;
+		// Number of simulated objects.
+		size_t objects;
+		// Wall clock time of the run in seconds.
+		double seconds;
+		// Simulation steps executed per second of wall clock time.
+		double stepsPerSecond;
+		// Object updates (steps * objects) executed per second of wall clock time.
+		double bodyStepsPerSecond;
+	};
 
 	/**
 	 * @brief Runs the main application loop.
 	 */
 	void run();
 
+	/**
+	 * @brief Advances the simulation without opening a window.
+	 * No input is polled and nothing is drawn, the objects are only updated with a fixed time step
+	 * as fast as the machine allows. The run itself does not allocate, and once the scratch buffers of the passes
+	 * have grown to their working size the steps do not either.
+	 *
+	 * @param steps Number of simulation steps to execute.
+	 * @param dt Fixed time step of every simulation step in seconds.
+	 * @param script Input fed to the controllers, one snapshot per step. No keys are held by default.
+	 * @return HeadlessStats Timing report of the run.
+	 */
+	HeadlessStats runHeadless(size_t steps, float dt, const InputScript &script = {});
+
+	/**
+	 * @brief Returns the pairs of bodies whose bounding boxes overlapped after the last physics step.
+	 * The bodies are identified by their rl::BodyStore handle, see rl::Object::body.
+	 */
+	const std::vector<rl::Broadphase::Pair> &collisionPairs() const;
+
+	/**
+	 * @brief Returns the bodies whose bounding boxes overlapped the box after the last physics step.
+	 *
+	 * @param box World space axis aligned box.
+	 */
+	std::vector<rl::BodyStore::Handle> queryBox(const BoundingBox &box) const;
+
+	/**
+	 * @brief Returns the contacts between the bodies resolved in the last physics step.
+	 */
+	const std::vector<rl::Contact> &contacts() const;
+
 	~Application();
 
+private:
+	/**
+	 * @brief Uploads the models loaded in the background within the upload budget and hands them
+	 * to their objects.
+	 */
+	void stream();
+	/**
+	 * @brief Starts watching the configuration and asset files of all the objects.
+	 */
+	void watchFiles();
+	/**
+	 * @brief Parses a changed configuration file and queues it to be applied. Called on the watcher thread.
+	 */
+	void fileChanged(const std::filesystem::path &path);
+	/**
+	 * @brief Applies the queued file changes to the objects using the files. Called between frames.
+	 */
+	void applyReloads();
+	/**
+	 * @brief Computes the render state of all the objects between the last two physics states.
+	 *
+	 * @param alpha Interpolation factor in range [0, 1], 0 being the previous and 1 the current state.
+	 */
+	void interpolate(float alpha);
+	/**
+	 * @brief Updates all the objects by a single time step.
+	 *
+	 * @param dt Time step in seconds.
+	 * @param input Input snapshot of the step.
+	 */
+	void step(float dt, const InputState &input);
+	/**
+	 * @brief Places of an object in the application, found from its handle in constant time.
+	 */
+	struct Entry
+	{
+		// Index of the object in m_objects.
+		size_t object;
+		// Index of the update lane of the object and its slot in the lane.
+		size_t lane;
+		size_t slot;
+	};
+
+	// Dynamic type and body precision shared by the objects of a lane.
+	using LaneKey = std::pair<std::type_index, rl::Precision>;
+
+	/**
+	 * @brief Adds the object to the update lane of its type and precision, the lane is created with its first object.
+	 */
+	void addToLane(Entry &entry, const rl::Object::Ptr &object, rl::PoolHandle handle);
+
 private:
 	Config m_config;
 	Camera m_camera;
+	// Fixed physics time step derived from the configured physics rate.
+	float m_physicsDt;
+	// Frame time that has not been simulated by a physics step yet.
+	float m_accumulator = 0.0f;
 	std::vector<rl::Object::Ptr> m_objects;
+	// Handles of the objects, index by index of m_objects. The entries they refer to live in rl::Pool<Entry>.
+	std::vector<rl::PoolHandle> m_handles;
+	// Index of the object the camera follows, cycled with the I key.
+	size_t m_followed = 0;
+	// Objects grouped by their type and precision, updated lane by lane, see rl::ObjectFactory::lane.
+	std::vector<std::unique_ptr<rl::UpdateLane>> m_lanes;
+	std::map<LaneKey, size_t> m_laneIndex;
+	// Worker threads running the parallel passes of every frame.
+	rl::JobSystem m_jobs;
+	// Background thread parsing the models, kept apart so the frame passes never wait on a load.
+	rl::JobSystem m_streaming{ 1 };
+	// Render rotations of the objects (x, y, z, w) and their rotation matrices, reused every frame.
+	std::array<std::vector<float>, 4> m_renderRotations;
+	std::vector<Matrix> m_renderTransforms;
+	// Objects whose model is still streaming in.
+	std::vector<rl::PoolHandle> m_loading;
+	// Collision candidates of the bodies after the last physics step.
+	rl::Broadphase m_broadphase;
+	// Contacts of the candidates and their response.
+	rl::Narrowphase m_narrowphase;
+	// Frame time percentiles shown in the HUD.
+	rl::FrameStats m_frameStats;
+
+	/**
+	 * @brief Changed file waiting to be applied, with the reparsed configuration if it is a configuration file.
+	 */
+	struct Reload
+	{
+		std::filesystem::path path;
+		std::optional<rl::Model> config;
+	};
+	std::mutex m_reloadMutex;
+	std::vector<Reload> m_reloads;
+	// Declared last, so its thread stops before anything it queues to is destroyed.
+	std::unique_ptr<rl::FileWatcher> m_watcher;
 };
 
 
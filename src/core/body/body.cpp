@@ -0,0 +1,613 @@
+#include "body.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+// Number of bodies processed by both integration passes before moving on, so the
+// state touched by the rigid body pass is still in cache for the kinematics pass.
+constexpr size_t BLOCK_SIZE = 256;
+
+// Smallest fraction of the time step the adaptive integrator takes, bounds the work of a single step.
+constexpr int MAX_SUBSTEPS = 64;
+// Hard bound of the attempts of a single adaptive step, accepted and rejected ones, so no input can hang it.
+constexpr int MAX_ATTEMPTS = 4 * MAX_SUBSTEPS;
+
+namespace
+{
+
+/**
+ * @brief Time derivative of the pose, the world frame linear velocity and the rate of the rotation quaternion.
+ */
+template <typename S>
+struct PoseRate
+{
+	rl::Vec3<S> position;
+	rl::Vec4<S> rotation;
+};
+
+/**
+ * @brief Evaluates the stages of an explicit Runge-Kutta step of the given coefficients.
+ * The velocities are constant over the step, so the rates only depend on the rotation.
+ */
+template <typename S, size_t N>
+std::array<PoseRate<S>, N> poseRates(const rl::Vec4<S> &q, const rl::Vec3<S> &v, const rl::Vec3<S> &omega, S h,
+	const double (&a)[N][N])
+{
+	const rl::Vec4<S> rate(omega.x(), omega.y(), omega.z(), S(0));
+
+	std::array<PoseRate<S>, N> k;
+	for (size_t stage = 0; stage < N; ++stage) {
+		rl::Vec4<S> qs = q;
+		for (size_t j = 0; j < stage; ++j) {
+			qs += (S(a[stage][j]) * h) * k[j].rotation;
+		}
+		// p_dot = q * v * q', q_dot = 0.5 * q * [omega, 0]. The stage rotation leaves the unit sphere, the velocity
+		// is rotated by its normalized rotation.
+		k[stage] = { rl::BasicQuaternion<S>(qs).normalize().rotateVector(v), S(0.5f) * rl::detail::multiply<S>(qs, rate) };
+	}
+	return k;
+}
+
+/**
+ * @brief Returns the weighted sum of a component of the stage rates.
+ */
+template <typename S, size_t N, typename Vector>
+Vector combine(const std::array<PoseRate<S>, N> &k, const double (&weights)[N], Vector PoseRate<S>::*component)
+{
+	Vector sum = Vector::Zero();
+	for (size_t stage = 0; stage < N; ++stage) {
+		sum += S(weights[stage]) * (k[stage].*component);
+	}
+	return sum;
+}
+
+// Classic fourth order Runge-Kutta.
+constexpr double RK4_A[4][4] = {
+	{},
+	{ 0.5 },
+	{ 0.0, 0.5 },
+	{ 0.0, 0.0, 1.0 },
+};
+constexpr double RK4_B[4] = { 1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 };
+
+// Dormand-Prince 5(4), the fifth order weights and their difference to the embedded fourth order ones.
+constexpr double DP_A[7][7] = {
+	{},
+	{ 1.0 / 5.0 },
+	{ 3.0 / 40.0, 9.0 / 40.0 },
+	{ 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0 },
+	{ 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0 },
+	{ 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0 },
+	{ 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 },
+};
+constexpr double DP_B[7] = { 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0, 0.0 };
+constexpr double DP_E[7] = { 71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0, -17253.0 / 339200.0, 22.0 / 525.0,
+	-1.0 / 40.0 };
+
+}
+
+rl::Integrator rl::integratorFromName(std::string_view name)
+{
+	if (name == "euler") {
+		return Integrator::Euler;
+	}
+	if (name == "semi-implicit") {
+		return Integrator::SemiImplicitEuler;
+	}
+	if (name == "rk4") {
+		return Integrator::RungeKutta4;
+	}
+	if (name == "exponential") {
+		return Integrator::Exponential;
+	}
+	if (name == "rk45") {
+		return Integrator::RungeKutta45;
+	}
+	throw std::invalid_argument("Unknown integrator [" + std::string(name) + "]");
+}
+
+template <typename S>
+rl::BasicBodyStore<S> &rl::BasicBodyStore<S>::instance()
+{
+	static BasicBodyStore instance;
+	return instance;
+}
+
+template <typename S>
+std::array<std::vector<S> *, rl::BasicBodyStore<S>::SCALAR_ARRAYS> rl::BasicBodyStore<S>::scalarArrays()
+{
+	std::array<std::vector<S> *, SCALAR_ARRAYS> arrays;
+	size_t count = 0;
+	auto append = [&arrays, &count](auto &components) {
+		for (auto &component : components) {
+			arrays[count++] = &component;
+		}
+	};
+
+	append(m_position);
+	append(m_prevPosition);
+	append(m_rotation);
+	append(m_prevRotation);
+	append(m_velocity);
+	append(m_tau);
+	append(m_feedbackTau);
+	append(m_boundsCenter);
+	append(m_boundsRotation);
+	append(m_boundsHalfExtent);
+
+	assert(count == SCALAR_ARRAYS);
+	return arrays;
+}
+
+template <typename S>
+typename rl::BasicBodyStore<S>::Handle rl::BasicBodyStore<S>::add(const Vector3 &position, const rl::Quaternion &rotation, float mass,
+	const Matrix3f &inertia)
+{
+	Handle handle;
+	if (m_freeHandles.empty()) {
+		handle = m_handleToIndex.size();
+		m_handleToIndex.push_back(0);
+	}
+	else {
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	}
+
+	size_t idx = size();
+	m_handleToIndex[handle] = idx;
+	m_indexToHandle.push_back(handle);
+
+	for (auto *array : scalarArrays()) {
+		array->push_back(S(0));
+	}
+
+	m_massProperties.emplace_back();
+	setMass(handle, mass, inertia);
+	setBounds(handle, BoundingBox{ Vector3{ -0.5f, -0.5f, -0.5f }, Vector3{ 0.5f, 0.5f, 0.5f } });
+
+	reset(handle, position, rotation);
+	return handle;
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::setMass(Handle handle, float mass, const Matrix3f &inertia)
+{
+	size_t idx = index(handle);
+
+	Mat3<S> I = inertia.cast<S>();
+	Mat3<S> invI = I.inverse();
+
+	// Only the upper triangle is stored, the tensors are symmetric.
+	auto &properties = m_massProperties[idx];
+	constexpr int rows[6] = { 0, 1, 2, 0, 0, 1 };
+	constexpr int cols[6] = { 0, 1, 2, 1, 2, 2 };
+	for (int c = 0; c < 6; ++c) {
+		properties.inertia[c] = I(rows[c], cols[c]);
+		properties.invInertia[c] = invI(rows[c], cols[c]);
+	}
+	properties.mass = mass;
+	properties.invMass = S(1) / S(mass);
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::reserve(size_t count)
+{
+	for (auto *array : scalarArrays()) {
+		array->reserve(count);
+	}
+	m_massProperties.reserve(count);
+	m_handleToIndex.reserve(count);
+	m_indexToHandle.reserve(count);
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::remove(Handle handle)
+{
+	size_t idx = index(handle);
+	size_t last = size() - 1;
+
+	// Move the last body into the freed slot to keep the arrays dense.
+	if (idx != last) {
+		for (auto *array : scalarArrays()) {
+			(*array)[idx] = (*array)[last];
+		}
+		m_massProperties[idx] = m_massProperties[last];
+
+		Handle moved = m_indexToHandle[last];
+		m_indexToHandle[idx] = moved;
+		m_handleToIndex[moved] = idx;
+	}
+
+	for (auto *array : scalarArrays()) {
+		array->pop_back();
+	}
+	m_massProperties.pop_back();
+	m_indexToHandle.pop_back();
+	m_freeHandles.push_back(handle);
+}
+
+template <typename S>
+size_t rl::BasicBodyStore<S>::size() const
+{
+	return m_indexToHandle.size();
+}
+
+template <typename S>
+size_t rl::BasicBodyStore<S>::index(Handle handle) const
+{
+	return m_handleToIndex[handle];
+}
+
+template <typename S>
+typename rl::BasicBodyStore<S>::Handle rl::BasicBodyStore<S>::handle(size_t index) const
+{
+	return m_indexToHandle[index];
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::integrate(float dt)
+{
+	integrate(0, size(), dt);
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::integrate(size_t begin, size_t end, float dt)
+{
+	for (size_t block = begin; block < end; block += BLOCK_SIZE) {
+		size_t blockEnd = std::min(block + BLOCK_SIZE, end);
+
+		for (size_t c = 0; c < 3; ++c) {
+			std::copy(m_position[c].begin() + block, m_position[c].begin() + blockEnd, m_prevPosition[c].begin() + block);
+		}
+		for (size_t c = 0; c < 4; ++c) {
+			std::copy(m_rotation[c].begin() + block, m_rotation[c].begin() + blockEnd, m_prevRotation[c].begin() + block);
+		}
+
+		rigidBody(block, blockEnd, dt);
+		kinematics(block, blockEnd, dt);
+	}
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::rigidBody(size_t begin, size_t end, float dt)
+{
+	const S time = responseTime(dt);
+	for (size_t i = begin; i < end; ++i) {
+		Vec3<S> force(m_tau[0][i] - m_feedbackTau[0][i], m_tau[1][i] - m_feedbackTau[1][i],
+			m_tau[2][i] - m_feedbackTau[2][i]);
+		Vec3<S> moment(m_tau[3][i] - m_feedbackTau[3][i], m_tau[4][i] - m_feedbackTau[4][i],
+			m_tau[5][i] - m_feedbackTau[5][i]);
+
+		const auto &properties = m_massProperties[i];
+
+		// nu = Mrb^-1 * tau * time, split into the mass and the inertia blocks.
+		Vec3<S> v = (properties.invMass * time) * force;
+		Vec3<S> omega = symmetricProduct(properties.invInertia, moment) * time;
+
+		// Coriolis feedback, omega x (m v) and omega x (I omega).
+		Vec3<S> pt1 = omega.cross(properties.mass * v);
+		Vec3<S> pt2 = omega.cross(symmetricProduct(properties.inertia, omega));
+		for (int c = 0; c < 3; ++c) {
+			m_feedbackTau[c][i] = pt1[c];
+			m_feedbackTau[c + 3][i] = pt2[c];
+			m_velocity[c][i] = v[c];
+			m_velocity[c + 3][i] = omega[c];
+		}
+	}
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::setIntegrator(Integrator integrator, float tolerance)
+{
+	m_integrator = integrator;
+	m_tolerance = tolerance;
+}
+
+template <typename S>
+rl::Integrator rl::BasicBodyStore<S>::integrator() const
+{
+	return m_integrator;
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::setResponseTime(float seconds)
+{
+	m_responseTime = seconds;
+}
+
+template <typename S>
+S rl::BasicBodyStore<S>::responseTime(float dt) const
+{
+	return m_responseTime > S(0) ? m_responseTime : S(dt);
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::kinematics(size_t begin, size_t end, float dt)
+{
+	const S h = S(dt);
+
+	switch (m_integrator) {
+	case Integrator::Euler:
+		kinematicsLoop(begin, end, [h](Vec3<S> &p, BasicQuaternion<S> &q, const Vec3<S> &v, const Vec3<S> &omega) {
+			constexpr int L = 100;
+
+			// Position, the linear velocity is rotated into the world frame (q * v * q').
+			p += q.rotateVector(v) * h;
+
+			// Rotation, q_dot = 0.5 * q * [omega, 0]
+			q.integrate(omega, h);
+
+			// Drive the quaternion back to the unit sphere and normalize.
+			q.axpy(L * (S(1) - q.dot(q)), q).normalize();
+		});
+		break;
+	case Integrator::SemiImplicitEuler:
+		kinematicsLoop(begin, end, [h](Vec3<S> &p, BasicQuaternion<S> &q, const Vec3<S> &v, const Vec3<S> &omega) {
+			q.integrate(omega, h).normalize();
+			p += q.rotateVector(v) * h;
+		});
+		break;
+	case Integrator::RungeKutta4:
+		kinematicsLoop(begin, end, [h](Vec3<S> &p, BasicQuaternion<S> &q, const Vec3<S> &v, const Vec3<S> &omega) {
+			auto k = poseRates(q.data(), v, omega, h, RK4_A);
+			p += h * combine(k, RK4_B, &PoseRate<S>::position);
+			q = BasicQuaternion<S>(q.data() + h * combine(k, RK4_B, &PoseRate<S>::rotation)).normalize();
+		});
+		break;
+	case Integrator::Exponential:
+		kinematicsLoop(begin, end, [h](Vec3<S> &p, BasicQuaternion<S> &q, const Vec3<S> &v, const Vec3<S> &omega) {
+			// The body rate is constant over the step, so q(t) = q * exp(omega t / 2) exactly. The rotation
+			// of the half step is applied twice and the position moves along the rotation at the midpoint.
+			auto half = BasicQuaternion<S>::fromRotationVector(omega * (S(0.5f) * h));
+			q *= half;
+			p += q.rotateVector(v) * h;
+			q *= half;
+			q.normalize();
+		});
+		break;
+	case Integrator::RungeKutta45:
+		kinematicsLoop(begin, end, [h, tolerance = m_tolerance](Vec3<S> &p, BasicQuaternion<S> &q, const Vec3<S> &v,
+			const Vec3<S> &omega) {
+			const S minStep = h / S(MAX_SUBSTEPS);
+			S t = 0;
+			S step = h;
+			for (int attempt = 0; t < h && attempt < MAX_ATTEMPTS; ++attempt) {
+				step = std::min(step, h - t);
+				auto k = poseRates(q.data(), v, omega, step, DP_A);
+
+				// Difference of the embedded fourth order solution to the fifth order one.
+				S error = step * std::max(combine(k, DP_E, &PoseRate<S>::position).template lpNorm<Eigen::Infinity>(),
+					combine(k, DP_E, &PoseRate<S>::rotation).template lpNorm<Eigen::Infinity>());
+
+				// An overflowing step is retried shorter, at the smallest step the velocities themselves are not
+				// finite and the body keeps its last finite pose.
+				if (!std::isfinite(error)) {
+					if (step <= minStep) {
+						break;
+					}
+					step = std::max(step * S(0.2f), minStep);
+					continue;
+				}
+
+				if (error <= tolerance || step <= minStep) {
+					p += step * combine(k, DP_B, &PoseRate<S>::position);
+					q = BasicQuaternion<S>(q.data() + step * combine(k, DP_B, &PoseRate<S>::rotation)).normalize();
+					t += step;
+				}
+
+				S factor = error > S(0) ? S(0.9f) * std::pow(tolerance / error, S(0.2f)) : S(5);
+				step = std::max(step * std::clamp(factor, S(0.2f), S(5)), minStep);
+			}
+		});
+		break;
+	}
+}
+
+template <typename S>
+template <typename Step>
+void rl::BasicBodyStore<S>::kinematicsLoop(size_t begin, size_t end, Step &&step)
+{
+	S *__restrict px = m_position[0].data();
+	S *__restrict py = m_position[1].data();
+	S *__restrict pz = m_position[2].data();
+	S *__restrict qx = m_rotation[0].data();
+	S *__restrict qy = m_rotation[1].data();
+	S *__restrict qz = m_rotation[2].data();
+	S *__restrict qw = m_rotation[3].data();
+	const S *__restrict vx = m_velocity[0].data();
+	const S *__restrict vy = m_velocity[1].data();
+	const S *__restrict vz = m_velocity[2].data();
+	const S *__restrict wx = m_velocity[3].data();
+	const S *__restrict wy = m_velocity[4].data();
+	const S *__restrict wz = m_velocity[5].data();
+
+	// The quaternion operations are fused and inlined, the loop body keeps the state in registers.
+	for (size_t i = begin; i < end; ++i) {
+		Vec3<S> p(px[i], py[i], pz[i]);
+		rl::BasicQuaternion<S> q(qx[i], qy[i], qz[i], qw[i]);
+
+		step(p, q, Vec3<S>(vx[i], vy[i], vz[i]), Vec3<S>(wx[i], wy[i], wz[i]));
+
+		px[i] = p.x();
+		py[i] = p.y();
+		pz[i] = p.z();
+		const auto &data = q.data();
+		qx[i] = data.x();
+		qy[i] = data.y();
+		qz[i] = data.z();
+		qw[i] = data.w();
+	}
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::setTorque(Handle handle, const Vector6f &tau)
+{
+	size_t idx = index(handle);
+	for (int c = 0; c < 6; ++c) {
+		m_tau[c][idx] = tau[c];
+	}
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::reset(Handle handle, const Vector3 &position, const rl::Quaternion &rotation)
+{
+	size_t idx = index(handle);
+	const S p[3] = { position.x, position.y, position.z };
+	const S q[4] = { rotation.x(), rotation.y(), rotation.z(), rotation.w() };
+
+	for (int c = 0; c < 3; ++c) {
+		m_position[c][idx] = m_prevPosition[c][idx] = p[c];
+	}
+	for (int c = 0; c < 4; ++c) {
+		m_rotation[c][idx] = m_prevRotation[c][idx] = q[c];
+	}
+	for (int c = 0; c < 6; ++c) {
+		m_velocity[c][idx] = 0.0f;
+		m_tau[c][idx] = 0.0f;
+		m_feedbackTau[c][idx] = 0.0f;
+	}
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::setBounds(Handle handle, const BoundingBox &bounds)
+{
+	Vector3f min(bounds.min.x, bounds.min.y, bounds.min.z);
+	Vector3f max(bounds.max.x, bounds.max.y, bounds.max.z);
+	setBounds(handle, 0.5f * (min + max), rl::Quaternion(0, 0, 0, 1), 0.5f * (max - min));
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::setBounds(Handle handle, const Vector3f &center, const rl::Quaternion &rotation, const Vector3f &halfExtent)
+{
+	size_t idx = index(handle);
+	const S q[4] = { rotation.x(), rotation.y(), rotation.z(), rotation.w() };
+
+	for (int c = 0; c < 3; ++c) {
+		m_boundsCenter[c][idx] = center[c];
+		m_boundsHalfExtent[c][idx] = halfExtent[c];
+	}
+	for (int c = 0; c < 4; ++c) {
+		m_boundsRotation[c][idx] = q[c];
+	}
+}
+
+template <typename S>
+rl::Vec6<S> rl::BasicBodyStore<S>::generalized(size_t idx, const Vec3<S> &point, const Vec3<S> &direction) const
+{
+	Mat3<S> R = rotationAt(idx).toRotationMatrix();
+	Vec3<S> arm(point.x() - m_position[0][idx], point.y() - m_position[1][idx], point.z() - m_position[2][idx]);
+
+	// Both the direction and the lever arm in the body frame, the velocities are body frame quantities.
+	Vec3<S> force = R.transpose() * direction;
+	Vec6<S> generalized;
+	generalized << force, (R.transpose() * arm).cross(force);
+	return generalized;
+}
+
+template <typename S>
+Vector3f rl::BasicBodyStore<S>::pointVelocity(Handle handle, const Vector3f &point) const
+{
+	size_t idx = index(handle);
+	Mat3<S> R = rotationAt(idx).toRotationMatrix();
+	Vec3<S> arm(point.x() - m_position[0][idx], point.y() - m_position[1][idx], point.z() - m_position[2][idx]);
+
+	Vec3<S> v(m_velocity[0][idx], m_velocity[1][idx], m_velocity[2][idx]);
+	Vec3<S> omega(m_velocity[3][idx], m_velocity[4][idx], m_velocity[5][idx]);
+	return (R * v + (R * omega).cross(arm)).template cast<float>();
+}
+
+template <typename S>
+float rl::BasicBodyStore<S>::inverseMass(Handle handle, const Vector3f &point, const Vector3f &direction) const
+{
+	size_t idx = index(handle);
+	Vec6<S> g = generalized(idx, point.cast<S>(), direction.cast<S>());
+	Vec3<S> moment = g.template tail<3>();
+	const auto &properties = m_massProperties[idx];
+	return float(properties.invMass * g.template head<3>().squaredNorm()
+		+ moment.dot(symmetricProduct(properties.invInertia, moment)));
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::applyImpulse(Handle handle, const Vector3f &point, const Vector3f &impulse, float dt)
+{
+	size_t idx = index(handle);
+	Vec6<S> g = generalized(idx, point.cast<S>(), impulse.cast<S>());
+	Vec6<S> nu;
+	const auto &properties = m_massProperties[idx];
+	nu << properties.invMass * g.template head<3>(), symmetricProduct(properties.invInertia, g.template tail<3>());
+
+	for (int c = 0; c < 6; ++c) {
+		m_velocity[c][idx] += nu[c];
+		m_feedbackTau[c][idx] -= g[c] / responseTime(dt);
+	}
+}
+
+template <typename S>
+void rl::BasicBodyStore<S>::translate(Handle handle, const Vector3f &offset)
+{
+	size_t idx = index(handle);
+	for (int c = 0; c < 3; ++c) {
+		m_position[c][idx] += offset[c];
+	}
+}
+
+template <typename S>
+Vector3 rl::BasicBodyStore<S>::position(Handle handle) const
+{
+	size_t idx = index(handle);
+	return Vector3{ float(m_position[0][idx]), float(m_position[1][idx]), float(m_position[2][idx]) };
+}
+
+template <typename S>
+Vector3 rl::BasicBodyStore<S>::previousPosition(Handle handle) const
+{
+	size_t idx = index(handle);
+	return Vector3{ float(m_prevPosition[0][idx]), float(m_prevPosition[1][idx]), float(m_prevPosition[2][idx]) };
+}
+
+template <typename S>
+rl::Quaternion rl::BasicBodyStore<S>::rotation(Handle handle) const
+{
+	return rotationAt(index(handle)).template cast<float>();
+}
+
+template <typename S>
+rl::Quaternion rl::BasicBodyStore<S>::previousRotation(Handle handle) const
+{
+	size_t idx = index(handle);
+	return rl::BasicQuaternion<S>(m_prevRotation[0][idx], m_prevRotation[1][idx], m_prevRotation[2][idx],
+		m_prevRotation[3][idx]).template cast<float>();
+}
+
+template <typename S>
+Vector6f rl::BasicBodyStore<S>::velocity(Handle handle) const
+{
+	size_t idx = index(handle);
+	Vector6f nu;
+	for (int c = 0; c < 6; ++c) {
+		nu[c] = float(m_velocity[c][idx]);
+	}
+	return nu;
+}
+
+template <typename S>
+rl::BasicQuaternion<S> rl::BasicBodyStore<S>::rotationAt(size_t idx) const
+{
+	return rl::BasicQuaternion<S>(m_rotation[0][idx], m_rotation[1][idx], m_rotation[2][idx], m_rotation[3][idx]);
+}
+
+template <typename S>
+rl::Vec3<S> rl::BasicBodyStore<S>::symmetricProduct(const std::array<S, 6> &matrix, const Vec3<S> &v)
+{
+	const auto &[xx, yy, zz, xy, xz, yz] = matrix;
+	return Vec3<S>(
+		xx * v.x() + xy * v.y() + xz * v.z(),
+		xy * v.x() + yy * v.y() + yz * v.z(),
+		xz * v.x() + yz * v.y() + zz * v.z());
+}
+
+template class rl::BasicBodyStore<float>;
+template class rl::BasicBodyStore<double>;
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <raylib.h>
+
+#include "quaternion.h"
+
+using Matrix6f = rl::Mat6<float>;
+using Matrix6d = rl::Mat6<double>;
+
+namespace rl
+{
+
+/**
+ * @brief Scheme the kinematics pass integrates the positions and rotations with.
+ * The velocities of a step are constant over it, the schemes differ in how they follow the rotation during the step.
+ */
+enum class Integrator
+{
+	// Explicit Euler, the rotation is driven back to the unit sphere by a stiff correction term.
+	Euler,
+	// Rotation first, the position then moves along the rotated velocity.
+	SemiImplicitEuler,
+	// Classic fourth order Runge-Kutta.
+	RungeKutta4,
+	// Exact exponential map update of the rotation, midpoint rotation for the position.
+	Exponential,
+	// Dormand-Prince 5(4) with adaptive sub-steps, the local error is kept below the tolerance.
+	RungeKutta45,
+};
+
+/**
+ * @brief Returns the integrator of the name, "euler", "semi-implicit", "rk4", "exponential" or "rk45".
+ * Throws std::invalid_argument for unknown names.
+ */
+Integrator integratorFromName(std::string_view name);
+
+/**
+ * @class BasicBodyStore
+ * @brief Singleton structure-of-arrays storage of the rigid body states of all objects.
+ *
+ * Every state component (position, rotation, velocity, torques) is kept in its own contiguous array
+ * indexed by the body index, so the batched integration walks linear memory and the compiler can
+ * vectorize the loops. Objects refer to their body through a stable handle, because the index of a body
+ * changes when another body is removed.
+ *
+ * The state is stored and integrated in the scalar S, there is one store per precision. The interface towards
+ * the configuration, the controllers, the collisions and the renderer is in float, the values are converted
+ * where they cross it.
+ */
+template <typename S>
+class BasicBodyStore
+{
+public:
+	using Handle = uint32_t;
+	using Scalar = S;
+
+	/**
+	 * @brief Returns the singleton instance of the store of this precision.
+	 *
+	 * @return BasicBodyStore& Reference to the singleton instance.
+	 */
+	static BasicBodyStore &instance();
+
+	/**
+	 * @brief Adds a new rigid body to the store.
+	 *
+	 * @param position Initial position of the body.
+	 * @param rotation Initial rotation of the body.
+	 * @param mass Mass of the body.
+	 * @param inertia Inertia tensor of the body.
+	 * @return Handle Stable handle of the added body.
+	 */
+	Handle add(const Vector3 &position, const rl::Quaternion &rotation, float mass, const Matrix3f &inertia);
+	/**
+	 * @brief Changes the mass and the inertia tensor of the body, its state is kept.
+	 *
+	 * @param handle Handle of the body.
+	 * @param mass New mass of the body.
+	 * @param inertia New inertia tensor of the body.
+	 */
+	void setMass(Handle handle, float mass, const Matrix3f &inertia);
+	/**
+	 * @brief Reserves the state arrays for the number of bodies, so adding them in bulk does not reallocate.
+	 *
+	 * @param count Total number of bodies the store is expected to hold.
+	 */
+	void reserve(size_t count);
+	/**
+	 * @brief Removes the body from the store. The last body is moved into the freed slot.
+	 *
+	 * @param handle Handle of the body to be removed.
+	 */
+	void remove(Handle handle);
+
+	/**
+	 * @brief Returns the number of bodies in the store.
+	 */
+	size_t size() const;
+	/**
+	 * @brief Returns the current index of the body in the state arrays.
+	 *
+	 * @param handle Handle of the body.
+	 */
+	size_t index(Handle handle) const;
+	/**
+	 * @brief Returns the handle of the body stored at the index.
+	 *
+	 * @param index Index of the body in the state arrays.
+	 */
+	Handle handle(size_t index) const;
+
+	/**
+	 * @brief Selects the scheme the kinematics pass integrates all the bodies with.
+	 *
+	 * @param integrator Integration scheme.
+	 * @param tolerance Largest local error of a step of the adaptive rl::Integrator::RungeKutta45,
+	 * in the units of the position and the quaternion components.
+	 */
+	void setIntegrator(Integrator integrator, float tolerance = 1e-5f);
+	/**
+	 * @brief Returns the scheme the kinematics pass integrates the bodies with.
+	 */
+	Integrator integrator() const;
+	/**
+	 * @brief Sets the time the torques act over to produce the velocity of a step, nu = Mrb^-1 * tau * time.
+	 * The velocity is derived from the torques every step instead of being accumulated, so with the step time it
+	 * would scale with the physics rate. A fixed time keeps the speeds the same at any physics rate.
+	 *
+	 * @param seconds Response time in seconds, 0 uses the time step of the integration.
+	 */
+	void setResponseTime(float seconds);
+
+	/**
+	 * @brief Integrates all the bodies by a single time step.
+	 *
+	 * @param dt Time step in seconds.
+	 */
+	void integrate(float dt);
+	/**
+	 * @brief Integrates the bodies with indices in range [begin, end) by a single time step.
+	 * Disjoint ranges can be integrated concurrently.
+	 *
+	 * @param begin Index of the first body to integrate.
+	 * @param end Index one past the last body to integrate.
+	 * @param dt Time step in seconds.
+	 */
+	void integrate(size_t begin, size_t end, float dt);
+
+	/**
+	 * @brief Calculates the rigid body dynamics of the bodies in range [begin, end).
+	 * The resulting velocities are stored in the velocity arrays. First pass of integrate().
+	 *
+	 * The rigid body mass matrix is block diagonal, so instead of a dense 6x6 inverse the kernel uses the inverse
+	 * mass and the inverse inertia tensor, and computes the Coriolis feedback with two cross products.
+	 */
+	void rigidBody(size_t begin, size_t end, float dt);
+	/**
+	 * @brief Integrates the positions and rotations of the bodies in range [begin, end) from their velocities
+	 * with the selected integrator. Second pass of integrate().
+	 */
+	void kinematics(size_t begin, size_t end, float dt);
+
+	/**
+	 * @brief Sets the torque applied to the body during the next integration.
+	 *
+	 * @param handle Handle of the body.
+	 * @param tau The torque vector applied to the body.
+	 */
+	void setTorque(Handle handle, const Vector6f &tau);
+	/**
+	 * @brief Moves the body to the given pose and clears its velocity and feedback torque.
+	 *
+	 * @param handle Handle of the body.
+	 * @param position New position of the body.
+	 * @param rotation New rotation of the body.
+	 */
+	void reset(Handle handle, const Vector3 &position, const rl::Quaternion &rotation);
+	/**
+	 * @brief Sets the bounding box of the body in its local frame, scaled to the size the body is drawn at.
+	 * Bodies without a loaded mesh use a unit box.
+	 *
+	 * @param handle Handle of the body.
+	 * @param bounds Local bounding box of the body.
+	 */
+	void setBounds(Handle handle, const BoundingBox &bounds);
+	/**
+	 * @brief Sets an oriented bounding box of the body in its local frame.
+	 *
+	 * @param handle Handle of the body.
+	 * @param center Center of the box in the body frame.
+	 * @param rotation Rotation of the box axes relative to the body frame.
+	 * @param halfExtent Half extents of the box along its axes.
+	 */
+	void setBounds(Handle handle, const Vector3f &center, const rl::Quaternion &rotation, const Vector3f &halfExtent);
+
+	/**
+	 * @brief Returns the world velocity of a point attached to the body.
+	 *
+	 * @param handle Handle of the body.
+	 * @param point World position of the point.
+	 */
+	Vector3f pointVelocity(Handle handle, const Vector3f &point) const;
+	/**
+	 * @brief Returns the inverse of the mass the body opposes to an impulse along the direction at the point.
+	 *
+	 * @param handle Handle of the body.
+	 * @param point World position the impulse is applied at.
+	 * @param direction World direction of the impulse.
+	 */
+	float inverseMass(Handle handle, const Vector3f &point, const Vector3f &direction) const;
+	/**
+	 * @brief Applies an impulse to the body at the point.
+	 * The velocity changes immediately. As the velocity is derived from the torques every step, the impulse is also
+	 * fed into the feedback torque of the next integration, spread over its response time.
+	 *
+	 * @param handle Handle of the body.
+	 * @param point World position the impulse is applied at.
+	 * @param impulse World impulse vector.
+	 * @param dt Time step of the next integration in seconds.
+	 */
+	void applyImpulse(Handle handle, const Vector3f &point, const Vector3f &impulse, float dt);
+	/**
+	 * @brief Moves the body without changing its velocity.
+	 *
+	 * @param handle Handle of the body.
+	 * @param offset World offset the body is moved by.
+	 */
+	void translate(Handle handle, const Vector3f &offset);
+
+	Vector3 position(Handle handle) const;
+	Vector3 previousPosition(Handle handle) const;
+	rl::Quaternion rotation(Handle handle) const;
+	rl::Quaternion previousRotation(Handle handle) const;
+	Vector6f velocity(Handle handle) const;
+
+	/**
+	 * @brief Direct read access to the state arrays, indexed by the body index.
+	 *
+	 * @param component Component of the state, x, y, z (and w for rotations, linear then angular for velocities).
+	 */
+	const std::vector<S> &positions(size_t component) const { return m_position[component]; }
+	const std::vector<S> &rotations(size_t component) const { return m_rotation[component]; }
+	const std::vector<S> &velocities(size_t component) const { return m_velocity[component]; }
+	const std::vector<S> &boundsCenters(size_t component) const { return m_boundsCenter[component]; }
+	const std::vector<S> &boundsRotations(size_t component) const { return m_boundsRotation[component]; }
+	const std::vector<S> &boundsHalfExtents(size_t component) const { return m_boundsHalfExtent[component]; }
+
+private:
+	/**
+	 * @brief Mass properties of a body, read together by the rigid body pass, so they are kept in one record.
+	 * The inertia tensor and its inverse are in the body frame, symmetric, stored as (xx, yy, zz, xy, xz, yz).
+	 * The off diagonal entries are zero for the bodies whose frame is aligned with their principal axes.
+	 */
+	struct MassProperties
+	{
+		S mass;
+		S invMass;
+		std::array<S, 6> inertia;
+		std::array<S, 6> invInertia;
+	};
+
+	BasicBodyStore() = default;
+	BasicBodyStore(const BasicBodyStore &) = delete;
+	BasicBodyStore &operator=(const BasicBodyStore &) = delete;
+
+	// Number of the per-body scalar arrays, the components of all the state arrays below.
+	static constexpr size_t SCALAR_ARRAYS = 42;
+
+	/**
+	 * @brief Returns all the per-body scalar arrays, so they can be grown and shrunk together.
+	 * The pointers are returned by value, adding and removing bodies does not allocate once the arrays are reserved.
+	 */
+	std::array<std::vector<S> *, SCALAR_ARRAYS> scalarArrays();
+	/**
+	 * @brief Maps a world direction applied at a world point to the generalized body frame force (force, moment)
+	 * of the body at the index.
+	 */
+	Vec6<S> generalized(size_t idx, const Vec3<S> &point, const Vec3<S> &direction) const;
+	/**
+	 * @brief Returns the rotation of the body at the index in the precision of the store.
+	 */
+	rl::BasicQuaternion<S> rotationAt(size_t idx) const;
+	/**
+	 * @brief Returns the time the torques of a step of the duration dt act over, see setResponseTime.
+	 */
+	S responseTime(float dt) const;
+	/**
+	 * @brief Runs the integration step on the pose of every body in range [begin, end).
+	 * The step is called as step(position, rotation, linearVelocity, angularVelocity).
+	 */
+	template <typename Step>
+	void kinematicsLoop(size_t begin, size_t end, Step &&step);
+	/**
+	 * @brief Returns the product of a symmetric matrix stored as (xx, yy, zz, xy, xz, yz) with the vector.
+	 */
+	static Vec3<S> symmetricProduct(const std::array<S, 6> &matrix, const Vec3<S> &v);
+
+private:
+	// Current and previous position
+	std::array<std::vector<S>, 3> m_position;
+	std::array<std::vector<S>, 3> m_prevPosition;
+	// Current and previous rotation quaternion (x, y, z, w)
+	std::array<std::vector<S>, 4> m_rotation;
+	std::array<std::vector<S>, 4> m_prevRotation;
+	// Linear and angular velocity of the last step
+	std::array<std::vector<S>, 6> m_velocity;
+	// Applied and feedback (Coriolis) torques
+	std::array<std::vector<S>, 6> m_tau;
+	std::array<std::vector<S>, 6> m_feedbackTau;
+	// Center, rotation and half extents of the local bounding box
+	std::array<std::vector<S>, 3> m_boundsCenter;
+	std::array<std::vector<S>, 4> m_boundsRotation;
+	std::array<std::vector<S>, 3> m_boundsHalfExtent;
+	std::vector<MassProperties> m_massProperties;
+
+	Integrator m_integrator = Integrator::Euler;
+	S m_tolerance = S(1e-5f);
+	S m_responseTime = S(0);
+
+	// Sparse set mapping the handles to the indices and back
+	std::vector<uint32_t> m_handleToIndex;
+	std::vector<Handle> m_indexToHandle;
+	std::vector<Handle> m_freeHandles;
+};
+
+using BodyStore = BasicBodyStore<float>;
+using BodyStoreD = BasicBodyStore<double>;
+
+extern template class BasicBodyStore<float>;
+extern template class BasicBodyStore<double>;
+
+/**
+ * @brief Calls the function with the body store of the precision.
+ * Both stores have the same interface, so a generic lambda serves both.
+ *
+ * @param precision Precision of the store.
+ * @param function Function called with the store.
+ */
+template <typename Function>
+decltype(auto) withBodyStore(Precision precision, Function &&function)
+{
+	if (precision == Precision::Double) {
+		return function(BodyStoreD::instance());
+	}
+	return function(BodyStore::instance());
+}
+
+}
@@ -0,0 +1,375 @@
+#include "broadphase.h"
+
+#include "trace.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// Number of bodies whose bounding boxes are computed by a single job.
+constexpr size_t BOUNDS_GRAIN = 4096;
+// Number of bodies whose pairs are collected by a single job.
+constexpr size_t PAIRS_GRAIN = 1024;
+// Number of oversized bodies whose pairs are collected by a single job.
+constexpr size_t OVERSIZED_GRAIN = 64;
+// Percentile of the box extents the cells are sized by, larger bodies are not binned.
+constexpr float CELL_PERCENTILE = 0.9f;
+// Cell coordinates are clamped so far away bodies do not overflow them.
+constexpr float CELL_LIMIT = 1 << 30;
+// Buckets and occupancy bits per body.
+constexpr size_t BUCKETS_PER_BODY = 2;
+constexpr size_t OCCUPANCY_PER_BODY = 16;
+
+// Half of the 26 neighbour cells, the other half finds the same pairs from the opposite side.
+constexpr std::array<std::array<int32_t, 3>, 13> FORWARD_NEIGHBOURS = { {
+	{ 1, 0, 0 },
+	{ -1, 1, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+	{ -1, -1, 1 }, { 0, -1, 1 }, { 1, -1, 1 },
+	{ -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 },
+	{ -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 },
+} };
+
+template <typename Visitor>
+void rl::Broadphase::visitCells(const BoundingBox &box, Visitor &&visitor) const
+{
+	size_t binned = m_entries.size();
+
+	// A binned body can only overlap the box if its center lies within half a cell of the box.
+	float margin = 0.5f * m_cellSize;
+	Cell from = cell(box.min.x - margin, box.min.y - margin, box.min.z - margin);
+	Cell to = cell(box.max.x + margin, box.max.y + margin, box.max.z + margin);
+
+	double cells = 1.0;
+	for (int c = 0; c < 3; ++c) {
+		cells *= double(to[c]) - from[c] + 1.0;
+	}
+
+	// Large boxes cover more cells than there are bodies, visiting every body is cheaper.
+	if (cells > binned) {
+		for (uint32_t i : m_entries) {
+			visitor(i);
+		}
+		return;
+	}
+
+	for (int32_t z = from[2]; z <= to[2]; ++z) {
+		for (int32_t y = from[1]; y <= to[1]; ++y) {
+			for (int32_t x = from[0]; x <= to[0]; ++x) {
+				Cell current{ x, y, z };
+				uint32_t b = hash(current) & m_bucketMask;
+				for (uint32_t e = m_bucketStart[b]; e < m_bucketStart[b + 1]; ++e) {
+					uint32_t i = m_entries[e];
+					if (m_cells[i] == current) {
+						visitor(i);
+					}
+				}
+			}
+		}
+	}
+}
+
+template <typename S>
+void rl::Broadphase::update(const rl::BasicBodyStore<S> &store, rl::JobSystem &jobs)
+{
+	RL_TRACE_SCOPE("broadphase");
+	size_t count = store.size();
+
+	for (int c = 0; c < 3; ++c) {
+		m_min[c].resize(count);
+		m_max[c].resize(count);
+	}
+	m_handles.resize(count);
+	m_extents.resize(count);
+	m_cells.resize(count);
+	m_hashes.resize(count);
+
+	jobs.parallelFor(0, count, BOUNDS_GRAIN, [this, &store](size_t begin, size_t end) {
+		computeBounds(store, begin, end);
+	});
+
+	// Most of the bodies have to fit into a cell for the neighbour search to be complete, the rest is
+	// tested separately. Sizing the cells by the largest box would put most of the scene into a few cells.
+	m_cellSize = 1.0f;
+	if (count > 0) {
+		m_scratch.assign(m_extents.begin(), m_extents.end());
+		auto nth = m_scratch.begin() + size_t(CELL_PERCENTILE * float(count - 1));
+		std::nth_element(m_scratch.begin(), nth, m_scratch.end());
+		if (*nth > 0.0f) {
+			m_cellSize = *nth;
+		}
+	}
+
+	m_oversized.resize(count);
+	m_oversizedList.clear();
+	for (size_t i = 0; i < count; ++i) {
+		m_oversized[i] = m_extents[i] > m_cellSize;
+		if (m_oversized[i]) {
+			m_oversizedList.push_back(i);
+		}
+	}
+
+	jobs.parallelFor(0, count, BOUNDS_GRAIN, [this](size_t begin, size_t end) {
+		computeCells(begin, end);
+	});
+
+	buildGrid();
+
+	size_t chunks = (count + PAIRS_GRAIN - 1) / PAIRS_GRAIN;
+	m_chunkPairs.resize(chunks);
+	jobs.parallelFor(0, count, PAIRS_GRAIN, [this](size_t begin, size_t end) {
+		auto &pairs = m_chunkPairs[begin / PAIRS_GRAIN];
+		pairs.clear();
+		collectPairs(begin, end, pairs);
+	});
+
+	size_t oversized = m_oversizedList.size();
+	size_t oversizedChunks = (oversized + OVERSIZED_GRAIN - 1) / OVERSIZED_GRAIN;
+	m_oversizedChunkPairs.resize(oversizedChunks);
+	jobs.parallelFor(0, oversized, OVERSIZED_GRAIN, [this](size_t begin, size_t end) {
+		auto &pairs = m_oversizedChunkPairs[begin / OVERSIZED_GRAIN];
+		pairs.clear();
+		collectOversizedPairs(begin, end, pairs);
+	});
+	m_sweepPairs.clear();
+	sweepOversized(m_sweepPairs);
+
+	m_pairs.clear();
+	for (size_t chunk = 0; chunk < chunks; ++chunk) {
+		m_pairs.insert(m_pairs.end(), m_chunkPairs[chunk].begin(), m_chunkPairs[chunk].end());
+	}
+	for (size_t chunk = 0; chunk < oversizedChunks; ++chunk) {
+		m_pairs.insert(m_pairs.end(), m_oversizedChunkPairs[chunk].begin(), m_oversizedChunkPairs[chunk].end());
+	}
+	m_pairs.insert(m_pairs.end(), m_sweepPairs.begin(), m_sweepPairs.end());
+}
+
+const std::vector<rl::Broadphase::Pair> &rl::Broadphase::pairs() const
+{
+	return m_pairs;
+}
+
+std::vector<rl::BodyStore::Handle> rl::Broadphase::query(const BoundingBox &box) const
+{
+	std::vector<rl::BodyStore::Handle> result;
+	auto overlapsBox = [this, &box](size_t i) {
+		return m_min[0][i] <= box.max.x && m_max[0][i] >= box.min.x
+			&& m_min[1][i] <= box.max.y && m_max[1][i] >= box.min.y
+			&& m_min[2][i] <= box.max.z && m_max[2][i] >= box.min.z;
+	};
+
+	visitCells(box, [&](size_t i) {
+		if (overlapsBox(i)) {
+			result.push_back(m_handles[i]);
+		}
+	});
+	for (uint32_t i : m_oversizedList) {
+		if (overlapsBox(i)) {
+			result.push_back(m_handles[i]);
+		}
+	}
+	return result;
+}
+
+template <typename S>
+BoundingBox rl::Broadphase::bounds(const rl::BasicBodyStore<S> &store, rl::BodyStore::Handle handle) const
+{
+	size_t idx = store.index(handle);
+	return BoundingBox{
+		Vector3{ m_min[0][idx], m_min[1][idx], m_min[2][idx] },
+		Vector3{ m_max[0][idx], m_max[1][idx], m_max[2][idx] },
+	};
+}
+
+template <typename S>
+void rl::Broadphase::computeBounds(const rl::BasicBodyStore<S> &store, size_t begin, size_t end)
+{
+	const S *__restrict px = store.positions(0).data();
+	const S *__restrict py = store.positions(1).data();
+	const S *__restrict pz = store.positions(2).data();
+	const S *__restrict qx = store.rotations(0).data();
+	const S *__restrict qy = store.rotations(1).data();
+	const S *__restrict qz = store.rotations(2).data();
+	const S *__restrict qw = store.rotations(3).data();
+	const S *__restrict cx = store.boundsCenters(0).data();
+	const S *__restrict cy = store.boundsCenters(1).data();
+	const S *__restrict cz = store.boundsCenters(2).data();
+	const S *__restrict bx = store.boundsRotations(0).data();
+	const S *__restrict by = store.boundsRotations(1).data();
+	const S *__restrict bz = store.boundsRotations(2).data();
+	const S *__restrict bw = store.boundsRotations(3).data();
+	const S *__restrict hx = store.boundsHalfExtents(0).data();
+	const S *__restrict hy = store.boundsHalfExtents(1).data();
+	const S *__restrict hz = store.boundsHalfExtents(2).data();
+
+	for (size_t i = begin; i < end; ++i) {
+		S x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+
+		// Rotation matrix of the body, the center of the local box is rotated with the body.
+		S r00 = S(1) - S(2) * (y * y + z * z), r01 = S(2) * (x * y - z * w), r02 = S(2) * (x * z + y * w);
+		S r10 = S(2) * (x * y + z * w), r11 = S(1) - S(2) * (x * x + z * z), r12 = S(2) * (y * z - x * w);
+		S r20 = S(2) * (x * z - y * w), r21 = S(2) * (y * z + x * w), r22 = S(1) - S(2) * (x * x + y * y);
+		S centerX = px[i] + r00 * cx[i] + r01 * cy[i] + r02 * cz[i];
+		S centerY = py[i] + r10 * cx[i] + r11 * cy[i] + r12 * cz[i];
+		S centerZ = pz[i] + r20 * cx[i] + r21 * cy[i] + r22 * cz[i];
+
+		// Rotation matrix of the box axes in the world (body rotation * box rotation),
+		// the half extents are projected onto the world axes.
+		S ox = w * bx[i] + x * bw[i] + y * bz[i] - z * by[i];
+		S oy = w * by[i] - x * bz[i] + y * bw[i] + z * bx[i];
+		S oz = w * bz[i] + x * by[i] - y * bx[i] + z * bw[i];
+		S ow = w * bw[i] - x * bx[i] - y * by[i] - z * bz[i];
+		S o00 = S(1) - S(2) * (oy * oy + oz * oz), o01 = S(2) * (ox * oy - oz * ow), o02 = S(2) * (ox * oz + oy * ow);
+		S o10 = S(2) * (ox * oy + oz * ow), o11 = S(1) - S(2) * (ox * ox + oz * oz), o12 = S(2) * (oy * oz - ox * ow);
+		S o20 = S(2) * (ox * oz - oy * ow), o21 = S(2) * (oy * oz + ox * ow), o22 = S(1) - S(2) * (ox * ox + oy * oy);
+		S halfX = std::abs(o00) * hx[i] + std::abs(o01) * hy[i] + std::abs(o02) * hz[i];
+		S halfY = std::abs(o10) * hx[i] + std::abs(o11) * hy[i] + std::abs(o12) * hz[i];
+		S halfZ = std::abs(o20) * hx[i] + std::abs(o21) * hy[i] + std::abs(o22) * hz[i];
+
+		m_min[0][i] = float(centerX - halfX);
+		m_min[1][i] = float(centerY - halfY);
+		m_min[2][i] = float(centerZ - halfZ);
+		m_max[0][i] = float(centerX + halfX);
+		m_max[1][i] = float(centerY + halfY);
+		m_max[2][i] = float(centerZ + halfZ);
+		m_extents[i] = std::max({ m_max[0][i] - m_min[0][i], m_max[1][i] - m_min[1][i], m_max[2][i] - m_min[2][i] });
+		m_handles[i] = store.handle(i);
+	}
+}
+
+void rl::Broadphase::computeCells(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
+		m_cells[i] = cell(0.5f * (m_min[0][i] + m_max[0][i]), 0.5f * (m_min[1][i] + m_max[1][i]),
+			0.5f * (m_min[2][i] + m_max[2][i]));
+		m_hashes[i] = hash(m_cells[i]);
+	}
+}
+
+void rl::Broadphase::buildGrid()
+{
+	size_t count = m_handles.size();
+	size_t buckets = std::bit_ceil(std::max<size_t>(BUCKETS_PER_BODY * count, 1));
+	size_t bits = std::bit_ceil(std::max<size_t>(OCCUPANCY_PER_BODY * count, 64));
+	m_bucketMask = buckets - 1;
+	m_occupiedMask = bits - 1;
+
+	// Counting sort of the bodies by their bucket.
+	m_bucketStart.assign(buckets + 1, 0);
+	m_occupied.assign(bits / 64, 0);
+	for (size_t i = 0; i < count; ++i) {
+		if (m_oversized[i]) {
+			continue;
+		}
+		++m_bucketStart[(m_hashes[i] & m_bucketMask) + 1];
+		uint32_t bit = m_hashes[i] & m_occupiedMask;
+		m_occupied[bit / 64] |= uint64_t(1) << (bit % 64);
+	}
+	for (size_t b = 0; b < buckets; ++b) {
+		m_bucketStart[b + 1] += m_bucketStart[b];
+	}
+
+	m_entries.resize(count - m_oversizedList.size());
+	for (size_t i = 0; i < count; ++i) {
+		if (m_oversized[i]) {
+			continue;
+		}
+		// The start of the bucket is used as the insertion cursor and restored afterwards.
+		m_entries[m_bucketStart[m_hashes[i] & m_bucketMask]++] = i;
+	}
+	for (size_t b = buckets; b > 0; --b) {
+		m_bucketStart[b] = m_bucketStart[b - 1];
+	}
+	m_bucketStart[0] = 0;
+}
+
+void rl::Broadphase::collectPairs(size_t begin, size_t end, std::vector<Pair> &pairs) const
+{
+	auto collect = [this, &pairs](size_t i, const Cell &current, uint32_t cellHash, bool own) {
+		uint32_t b = cellHash & m_bucketMask;
+		for (uint32_t e = m_bucketStart[b]; e < m_bucketStart[b + 1]; ++e) {
+			uint32_t j = m_entries[e];
+			// Pairs within the own cell are reported by the body with the smaller index.
+			if ((own && j <= i) || m_cells[j] != current || !overlaps(i, j)) {
+				continue;
+			}
+			pairs.emplace_back(std::min(m_handles[i], m_handles[j]), std::max(m_handles[i], m_handles[j]));
+		}
+	};
+
+	for (size_t i = begin; i < end; ++i) {
+		if (m_oversized[i]) {
+			continue;
+		}
+		const Cell &own = m_cells[i];
+		collect(i, own, m_hashes[i], true);
+
+		for (const auto &offset : FORWARD_NEIGHBOURS) {
+			Cell neighbour{ own[0] + offset[0], own[1] + offset[1], own[2] + offset[2] };
+			uint32_t neighbourHash = hash(neighbour);
+			uint32_t bit = neighbourHash & m_occupiedMask;
+			if (m_occupied[bit / 64] >> (bit % 64) & 1) {
+				collect(i, neighbour, neighbourHash, false);
+			}
+		}
+	}
+}
+
+void rl::Broadphase::collectOversizedPairs(size_t begin, size_t end, std::vector<Pair> &pairs) const
+{
+	for (size_t k = begin; k < end; ++k) {
+		uint32_t i = m_oversizedList[k];
+		BoundingBox box{
+			Vector3{ m_min[0][i], m_min[1][i], m_min[2][i] },
+			Vector3{ m_max[0][i], m_max[1][i], m_max[2][i] },
+		};
+		visitCells(box, [this, &pairs, i](size_t j) {
+			if (overlaps(i, j)) {
+				pairs.emplace_back(std::min(m_handles[i], m_handles[j]), std::max(m_handles[i], m_handles[j]));
+			}
+		});
+	}
+}
+
+void rl::Broadphase::sweepOversized(std::vector<Pair> &pairs)
+{
+	// Ties are broken by the index so the order of the pairs does not depend on the sort.
+	std::sort(m_oversizedList.begin(), m_oversizedList.end(), [this](uint32_t lhs, uint32_t rhs) {
+		return m_min[0][lhs] != m_min[0][rhs] ? m_min[0][lhs] < m_min[0][rhs] : lhs < rhs;
+	});
+
+	for (size_t a = 0; a < m_oversizedList.size(); ++a) {
+		uint32_t i = m_oversizedList[a];
+		for (size_t b = a + 1; b < m_oversizedList.size() && m_min[0][m_oversizedList[b]] <= m_max[0][i]; ++b) {
+			uint32_t j = m_oversizedList[b];
+			if (overlaps(i, j)) {
+				pairs.emplace_back(std::min(m_handles[i], m_handles[j]), std::max(m_handles[i], m_handles[j]));
+			}
+		}
+	}
+}
+
+rl::Broadphase::Cell rl::Broadphase::cell(float x, float y, float z) const
+{
+	float scale = 1.0f / m_cellSize;
+	auto coordinate = [scale](float value) {
+		return int32_t(std::clamp(std::floor(value * scale), -CELL_LIMIT, CELL_LIMIT));
+	};
+	return Cell{ coordinate(x), coordinate(y), coordinate(z) };
+}
+
+uint32_t rl::Broadphase::hash(const Cell &cell)
+{
+	return uint32_t(cell[0]) * 73856093u ^ uint32_t(cell[1]) * 19349663u ^ uint32_t(cell[2]) * 83492791u;
+}
+
+bool rl::Broadphase::overlaps(size_t lhs, size_t rhs) const
+{
+	return m_min[0][lhs] <= m_max[0][rhs] && m_max[0][lhs] >= m_min[0][rhs]
+		&& m_min[1][lhs] <= m_max[1][rhs] && m_max[1][lhs] >= m_min[1][rhs]
+		&& m_min[2][lhs] <= m_max[2][rhs] && m_max[2][lhs] >= m_min[2][rhs];
+}
+
+template void rl::Broadphase::update(const rl::BodyStore &store, rl::JobSystem &jobs);
+template void rl::Broadphase::update(const rl::BodyStoreD &store, rl::JobSystem &jobs);
+template BoundingBox rl::Broadphase::bounds(const rl::BodyStore &store, rl::BodyStore::Handle handle) const;
+template BoundingBox rl::Broadphase::bounds(const rl::BodyStoreD &store, rl::BodyStore::Handle handle) const;
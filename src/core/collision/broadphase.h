@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <raylib.h>
+
+#include "body.h"
+#include "jobs.h"
+
+namespace rl
+{
+
+/**
+ * @class Broadphase
+ * @brief Uniform spatial hash over the world space bounding boxes of all the bodies.
+ *
+ * The local bounding box of every body is rotated and moved into a world space axis aligned box after
+ * each integration. The cells are sized from a percentile of the box extents so a few large bodies do not
+ * blow up the cells of all the others. Every body that fits into a cell is binned into the grid cell
+ * containing the center of its box, so two such boxes can only overlap if their cells are neighbours and
+ * every body is tested only against the bodies of its own and the neighbouring cells. The cells are hashed
+ * into a bucket array that is rebuilt by a counting sort in linear time every step.
+ *
+ * The oversized bodies are kept on a separate list. Each of them visits the cells its box covers to find
+ * the binned bodies, and they are tested against each other by a sweep along the x axis.
+ */
+class Broadphase
+{
+public:
+	using Pair = std::pair<rl::BodyStore::Handle, rl::BodyStore::Handle>;
+
+	/**
+	 * @brief Recomputes the bounding boxes of all the bodies and the candidate pairs.
+	 *
+	 * @param store Store with the integrated bodies, of either precision.
+	 * @param jobs Job system the bounding boxes and the pairs are computed on.
+	 */
+	template <typename S>
+	void update(const rl::BasicBodyStore<S> &store, rl::JobSystem &jobs);
+
+	/**
+	 * @brief Returns the pairs of bodies with overlapping bounding boxes found by the last update.
+	 * The smaller handle is always the first of the pair.
+	 */
+	const std::vector<Pair> &pairs() const;
+
+	/**
+	 * @brief Returns all the bodies whose bounding box overlaps the box, as of the last update.
+	 *
+	 * @param box World space axis aligned box.
+	 */
+	std::vector<rl::BodyStore::Handle> query(const BoundingBox &box) const;
+
+	/**
+	 * @brief Returns the world space bounding box of the body, as of the last update.
+	 *
+	 * @param store Store the body belongs to.
+	 * @param handle Handle of the body.
+	 */
+	template <typename S>
+	BoundingBox bounds(const rl::BasicBodyStore<S> &store, rl::BodyStore::Handle handle) const;
+
+private:
+	using Cell = std::array<int32_t, 3>;
+
+	/**
+	 * @brief Computes the world space boxes of the bodies with indices in range [begin, end).
+	 */
+	template <typename S>
+	void computeBounds(const rl::BasicBodyStore<S> &store, size_t begin, size_t end);
+	/**
+	 * @brief Sorts all the bodies into the buckets of their cells.
+	 */
+	void buildGrid();
+	/**
+	 * @brief Computes the cells of the bodies with indices in range [begin, end).
+	 */
+	void computeCells(size_t begin, size_t end);
+	/**
+	 * @brief Collects the pairs of the bodies with indices in range [begin, end) with the bodies
+	 * of the same and the following neighbour cells.
+	 */
+	void collectPairs(size_t begin, size_t end, std::vector<Pair> &pairs) const;
+	/**
+	 * @brief Collects the pairs of the oversized bodies in range [begin, end) of the oversized list
+	 * with the binned bodies.
+	 */
+	void collectOversizedPairs(size_t begin, size_t end, std::vector<Pair> &pairs) const;
+	/**
+	 * @brief Collects the pairs among the oversized bodies by sweeping them along the x axis.
+	 */
+	void sweepOversized(std::vector<Pair> &pairs);
+
+	/**
+	 * @brief Returns the cell containing the point.
+	 */
+	Cell cell(float x, float y, float z) const;
+	/**
+	 * @brief Returns the hash of the cell, the low bits select the bucket and the occupancy bit.
+	 */
+	static uint32_t hash(const Cell &cell);
+	/**
+	 * @brief Calls the visitor with every binned body whose center lies in one of the cells that a box
+	 * of at most one cell size can overlap the box from.
+	 */
+	template <typename Visitor>
+	void visitCells(const BoundingBox &box, Visitor &&visitor) const;
+	/**
+	 * @brief Returns true if the boxes of the bodies with the indices overlap.
+	 */
+	bool overlaps(size_t lhs, size_t rhs) const;
+
+private:
+	// World space boxes indexed by the body index.
+	std::array<std::vector<float>, 3> m_min;
+	std::array<std::vector<float>, 3> m_max;
+	std::vector<rl::BodyStore::Handle> m_handles;
+	// Largest axis extent of every box and a scratch copy the percentile is selected in.
+	std::vector<float> m_extents;
+	std::vector<float> m_scratch;
+
+	float m_cellSize = 1.0f;
+	// Bodies larger than a cell are not binned, their indices are listed separately.
+	std::vector<uint8_t> m_oversized;
+	std::vector<uint32_t> m_oversizedList;
+	std::vector<Cell> m_cells;
+	std::vector<uint32_t> m_hashes;
+	// Body indices grouped by bucket, the bodies of bucket b are in range [m_bucketStart[b], m_bucketStart[b + 1]).
+	uint32_t m_bucketMask = 0;
+	std::vector<uint32_t> m_bucketStart;
+	std::vector<uint32_t> m_entries;
+	// Most of the neighbour cells are empty. A bit per cell hash, finer than the buckets, is set
+	// for every occupied cell and is small enough to stay in the cache.
+	uint32_t m_occupiedMask = 0;
+	std::vector<uint64_t> m_occupied;
+
+	// Pairs found by the individual jobs, merged in order so the result does not depend on the scheduling.
+	std::vector<std::vector<Pair>> m_chunkPairs;
+	std::vector<std::vector<Pair>> m_oversizedChunkPairs;
+	std::vector<Pair> m_sweepPairs;
+	std::vector<Pair> m_pairs;
+};
+
+}
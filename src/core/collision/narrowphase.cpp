@@ -0,0 +1,266 @@
+#include "narrowphase.h"
+
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+// Number of candidate pairs tested by a single job.
+constexpr size_t PAIRS_GRAIN = 256;
+// Edge axes win over the face axes only if they are clearly better, face contacts are more stable.
+constexpr float EDGE_BIAS = 0.95f;
+// Below this length the cross product of two edges is treated as parallel edges.
+constexpr float PARALLEL_EPSILON = 1e-5f;
+
+namespace
+{
+
+/**
+ * @brief Oriented bounding box of a body in the world frame.
+ */
+struct WorldBox
+{
+	Vector3f center;
+	// Axes of the box as columns.
+	Matrix3f axes;
+	Vector3f halfExtent;
+};
+
+template <typename S>
+WorldBox worldBox(const rl::BasicBodyStore<S> &store, rl::BodyStore::Handle handle)
+{
+	size_t idx = store.index(handle);
+	Matrix3f body = store.rotation(handle).toRotationMatrix();
+	Vector3 p = store.position(handle);
+
+	Vector3f center(store.boundsCenters(0)[idx], store.boundsCenters(1)[idx], store.boundsCenters(2)[idx]);
+	rl::Quaternion rotation(store.boundsRotations(0)[idx], store.boundsRotations(1)[idx], store.boundsRotations(2)[idx],
+		store.boundsRotations(3)[idx]);
+
+	return WorldBox{
+		.center = Vector3f(p.x, p.y, p.z) + body * center,
+		.axes = body * rotation.toRotationMatrix(),
+		.halfExtent = Vector3f(store.boundsHalfExtents(0)[idx], store.boundsHalfExtents(1)[idx],
+			store.boundsHalfExtents(2)[idx]),
+	};
+}
+
+/**
+ * @brief Returns the center of the feature (face, edge or vertex) of the box furthest along the direction.
+ */
+Vector3f support(const WorldBox &box, const Vector3f &direction, int skip = -1)
+{
+	Vector3f point = box.center;
+	for (int k = 0; k < 3; ++k) {
+		float projection = box.axes.col(k).dot(direction);
+		if (k != skip && std::abs(projection) > PARALLEL_EPSILON) {
+			point += box.axes.col(k) * box.halfExtent[k] * (projection > 0.0f ? 1.0f : -1.0f);
+		}
+	}
+	return point;
+}
+
+/**
+ * @brief Clamps the point into the slab of the box along all its axes but the skipped one.
+ */
+Vector3f clampInto(const WorldBox &box, const Vector3f &point, int skip)
+{
+	Vector3f local = box.axes.transpose() * (point - box.center);
+	for (int k = 0; k < 3; ++k) {
+		if (k != skip) {
+			local[k] = std::clamp(local[k], -box.halfExtent[k], box.halfExtent[k]);
+		}
+	}
+	return box.center + box.axes * local;
+}
+
+/**
+ * @brief Returns the midpoint of the closest points of two lines.
+ */
+Vector3f closestPoints(const Vector3f &p1, const Vector3f &d1, const Vector3f &p2, const Vector3f &d2)
+{
+	Vector3f r = p1 - p2;
+	float a = d1.dot(d1), b = d1.dot(d2), c = d2.dot(d2), d = d1.dot(r), e = d2.dot(r);
+	float denominator = a * c - b * b;
+	if (std::abs(denominator) < PARALLEL_EPSILON) {
+		return 0.5f * (p1 + p2);
+	}
+
+	float s = (b * e - c * d) / denominator;
+	float t = (a * e - b * d) / denominator;
+	return 0.5f * ((p1 + d1 * s) + (p2 + d2 * t));
+}
+
+/**
+ * @brief Tests two boxes by the separating axis theorem.
+ *
+ * @return std::optional<rl::Contact> Contact along the axis of the least penetration, empty if the boxes are separated.
+ */
+std::optional<rl::Contact> collide(const WorldBox &A, const WorldBox &B)
+{
+	enum class Axis { FaceA, FaceB, Edge };
+
+	Vector3f d = B.center - A.center;
+	Matrix3f R = A.axes.transpose() * B.axes;
+	Matrix3f absR = R.cwiseAbs().array() + PARALLEL_EPSILON;
+	Vector3f t = A.axes.transpose() * d;
+
+	float best = std::numeric_limits<float>::max();
+	Vector3f normal;
+	Axis type = Axis::FaceA;
+	int first = 0, second = 0;
+
+	// Faces of A.
+	for (int i = 0; i < 3; ++i) {
+		float overlap = A.halfExtent[i] + B.halfExtent.dot(absR.row(i)) - std::abs(t[i]);
+		if (overlap < 0.0f) {
+			return std::nullopt;
+		}
+		if (overlap < best) {
+			best = overlap;
+			normal = A.axes.col(i) * (t[i] < 0.0f ? -1.0f : 1.0f);
+			type = Axis::FaceA;
+			first = i;
+		}
+	}
+
+	// Faces of B.
+	for (int j = 0; j < 3; ++j) {
+		float distance = d.dot(B.axes.col(j));
+		float overlap = A.halfExtent.dot(absR.col(j)) + B.halfExtent[j] - std::abs(distance);
+		if (overlap < 0.0f) {
+			return std::nullopt;
+		}
+		if (overlap < best) {
+			best = overlap;
+			normal = B.axes.col(j) * (distance < 0.0f ? -1.0f : 1.0f);
+			type = Axis::FaceB;
+			first = j;
+		}
+	}
+
+	// Edge pairs.
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			Vector3f axis = A.axes.col(i).cross(B.axes.col(j));
+			float length = axis.norm();
+			if (length < PARALLEL_EPSILON) {
+				continue;
+			}
+			axis /= length;
+
+			float distance = d.dot(axis);
+			float ra = (A.axes.transpose() * axis).cwiseAbs().dot(A.halfExtent);
+			float rb = (B.axes.transpose() * axis).cwiseAbs().dot(B.halfExtent);
+			float overlap = ra + rb - std::abs(distance);
+			if (overlap < 0.0f) {
+				return std::nullopt;
+			}
+			if (overlap < EDGE_BIAS * best) {
+				best = overlap;
+				normal = axis * (distance < 0.0f ? -1.0f : 1.0f);
+				type = Axis::Edge;
+				first = i;
+				second = j;
+			}
+		}
+	}
+
+	// The contact point lies halfway between the surfaces, on the feature penetrating the other box.
+	Vector3f point = Vector3f::Zero();
+	switch (type) {
+	case Axis::FaceA:
+		point = clampInto(A, support(B, -normal), first) + 0.5f * best * normal;
+		break;
+	case Axis::FaceB:
+		point = clampInto(B, support(A, normal), first) - 0.5f * best * normal;
+		break;
+	case Axis::Edge:
+		point = closestPoints(support(A, normal, first), A.axes.col(first), support(B, -normal, second), B.axes.col(second));
+		break;
+	}
+
+	return rl::Contact{ .a = 0, .b = 0, .point = point, .normal = normal, .depth = best };
+}
+
+}
+
+template <typename S>
+void rl::Narrowphase::update(const rl::BasicBodyStore<S> &store, const std::vector<rl::Broadphase::Pair> &pairs,
+	rl::JobSystem &jobs)
+{
+	RL_TRACE_SCOPE("narrowphase");
+
+	size_t chunks = (pairs.size() + PAIRS_GRAIN - 1) / PAIRS_GRAIN;
+	m_chunkContacts.resize(chunks);
+	jobs.parallelFor(0, pairs.size(), PAIRS_GRAIN, [this, &store, &pairs](size_t begin, size_t end) {
+		auto &contacts = m_chunkContacts[begin / PAIRS_GRAIN];
+		contacts.clear();
+		for (size_t i = begin; i < end; ++i) {
+			auto [a, b] = pairs[i];
+			if (auto contact = collide(worldBox(store, a), worldBox(store, b))) {
+				contact->a = a;
+				contact->b = b;
+				contacts.push_back(*contact);
+			}
+		}
+	});
+
+	m_contacts.clear();
+	for (size_t chunk = 0; chunk < chunks; ++chunk) {
+		m_contacts.insert(m_contacts.end(), m_chunkContacts[chunk].begin(), m_chunkContacts[chunk].end());
+	}
+}
+
+template <typename S>
+void rl::Narrowphase::resolve(rl::BasicBodyStore<S> &store, float dt) const
+{
+	RL_TRACE_SCOPE("resolve");
+
+	// Contacts share bodies, the impulses are applied sequentially and every pass sees the velocities of the previous one.
+	for (int iteration = 0; iteration < ITERATIONS; ++iteration) {
+		for (const auto &contact : m_contacts) {
+			Vector3f relative = store.pointVelocity(contact.b, contact.point) - store.pointVelocity(contact.a, contact.point);
+			float approaching = relative.dot(contact.normal);
+			if (approaching >= 0.0f) {
+				continue;
+			}
+
+			float inverseMass = store.inverseMass(contact.a, contact.point, contact.normal)
+				+ store.inverseMass(contact.b, contact.point, contact.normal);
+			Vector3f impulse = contact.normal * (-(1.0f + RESTITUTION) * approaching / inverseMass);
+			store.applyImpulse(contact.a, contact.point, -impulse, dt);
+			store.applyImpulse(contact.b, contact.point, impulse, dt);
+		}
+	}
+
+	// Push the bodies apart along the normal in the ratio of their inverse masses.
+	for (const auto &contact : m_contacts) {
+		float correction = std::max(contact.depth - SLOP, 0.0f) * CORRECTION;
+		if (correction == 0.0f) {
+			continue;
+		}
+
+		Vector3 a = store.position(contact.a);
+		Vector3 b = store.position(contact.b);
+		float weightA = store.inverseMass(contact.a, Vector3f(a.x, a.y, a.z), contact.normal);
+		float weightB = store.inverseMass(contact.b, Vector3f(b.x, b.y, b.z), contact.normal);
+		float total = weightA + weightB;
+		store.translate(contact.a, -contact.normal * (correction * weightA / total));
+		store.translate(contact.b, contact.normal * (correction * weightB / total));
+	}
+}
+
+const std::vector<rl::Contact> &rl::Narrowphase::contacts() const
+{
+	return m_contacts;
+}
+
+template void rl::Narrowphase::update(const rl::BodyStore &store, const std::vector<rl::Broadphase::Pair> &pairs,
+	rl::JobSystem &jobs);
+template void rl::Narrowphase::update(const rl::BodyStoreD &store, const std::vector<rl::Broadphase::Pair> &pairs,
+	rl::JobSystem &jobs);
+template void rl::Narrowphase::resolve(rl::BodyStore &store, float dt) const;
+template void rl::Narrowphase::resolve(rl::BodyStoreD &store, float dt) const;
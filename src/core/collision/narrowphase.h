@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+#include "body.h"
+#include "broadphase.h"
+#include "jobs.h"
+
+namespace rl
+{
+
+/**
+ * @class Contact
+ * @brief Contact between two bodies found by the narrowphase.
+ */
+struct Contact
+{
+	rl::BodyStore::Handle a;
+	rl::BodyStore::Handle b;
+	// World position of the contact point.
+	Vector3f point;
+	// World contact normal pointing from body a to body b.
+	Vector3f normal;
+	// Penetration depth along the normal.
+	float depth;
+};
+
+/**
+ * @class Narrowphase
+ * @brief Exact contact detection and impulse based response of the broadphase candidate pairs.
+ *
+ * Every body is represented by its oriented bounding box (rl::OrientedBox) fitted to the mesh at load time.
+ * The boxes of a candidate pair are tested by the separating axis theorem on their 15 potential separating axes.
+ * Overlapping boxes produce a single contact along the axis of the least penetration. The contacts are resolved
+ * by a fixed number of sequential impulse iterations and a positional correction pushing the bodies apart,
+ * so the cost per pair stays bounded.
+ */
+class Narrowphase
+{
+public:
+	// Ratio of the normal velocity the bodies separate with after an impact.
+	static constexpr float RESTITUTION = 0.2f;
+	// Number of passes over all the contacts when resolving them.
+	static constexpr int ITERATIONS = 4;
+	// Penetration that is tolerated, so resting contacts do not jitter.
+	static constexpr float SLOP = 0.01f;
+	// Portion of the penetration removed by a single positional correction.
+	static constexpr float CORRECTION = 0.8f;
+
+	/**
+	 * @brief Tests all the candidate pairs and collects the contacts.
+	 *
+	 * @param store Store with the integrated bodies, of either precision.
+	 * @param pairs Candidate pairs found by the broadphase.
+	 * @param jobs Job system the pairs are tested on.
+	 */
+	template <typename S>
+	void update(const rl::BasicBodyStore<S> &store, const std::vector<rl::Broadphase::Pair> &pairs, rl::JobSystem &jobs);
+
+	/**
+	 * @brief Applies the contact impulses to the velocities and separates the penetrating bodies.
+	 *
+	 * @param store Store the contacts were detected in.
+	 * @param dt Time step of the next integration in seconds.
+	 */
+	template <typename S>
+	void resolve(rl::BasicBodyStore<S> &store, float dt) const;
+
+	/**
+	 * @brief Returns the contacts found by the last update.
+	 */
+	const std::vector<Contact> &contacts() const;
+
+private:
+	// Pairs tested by the individual jobs, merged in order so the result does not depend on the scheduling.
+	std::vector<std::vector<Contact>> m_chunkContacts;
+	std::vector<Contact> m_contacts;
+};
+
+}
@@ -0,0 +1,80 @@
+#include "shape.h"
+
+#include "trace.h"
+
+#include <limits>
+
+namespace
+{
+
+/**
+ * @brief Returns the box with the given axes tightly enclosing all the vertices of the model.
+ */
+rl::OrientedBox enclose(const ::Model &model, const Matrix3f &axes)
+{
+	Vector3f min = Vector3f::Constant(std::numeric_limits<float>::max());
+	Vector3f max = Vector3f::Constant(std::numeric_limits<float>::lowest());
+
+	for (int m = 0; m < model.meshCount; ++m) {
+		const ::Mesh &mesh = model.meshes[m];
+		for (int v = 0; v < mesh.vertexCount; ++v) {
+			Vector3f projected = axes.transpose() * Vector3f(mesh.vertices[3 * v], mesh.vertices[3 * v + 1], mesh.vertices[3 * v + 2]);
+			min = min.cwiseMin(projected);
+			max = max.cwiseMax(projected);
+		}
+	}
+
+	Eigen::Quaternionf rotation(axes);
+	return rl::OrientedBox{
+		.center = axes * (0.5f * (min + max)),
+		.rotation = rl::Quaternion(rotation.x(), rotation.y(), rotation.z(), rotation.w()),
+		.halfExtent = 0.5f * (max - min),
+	};
+}
+
+}
+
+rl::OrientedBox rl::OrientedBox::fromModel(const ::Model &model, float scale)
+{
+	RL_TRACE_SCOPE("OrientedBox::fromModel");
+
+	// Covariance of the vertex cloud, its eigenvectors are the principal axes.
+	size_t count = 0;
+	Vector3f mean = Vector3f::Zero();
+	for (int m = 0; m < model.meshCount; ++m) {
+		const ::Mesh &mesh = model.meshes[m];
+		for (int v = 0; v < mesh.vertexCount; ++v) {
+			mean += Vector3f(mesh.vertices[3 * v], mesh.vertices[3 * v + 1], mesh.vertices[3 * v + 2]);
+		}
+		count += mesh.vertexCount;
+	}
+
+	if (count == 0) {
+		return OrientedBox{ Vector3f::Zero(), rl::Quaternion(0, 0, 0, 1), Vector3f::Constant(0.5f * scale) };
+	}
+	mean /= count;
+
+	Matrix3f covariance = Matrix3f::Zero();
+	for (int m = 0; m < model.meshCount; ++m) {
+		const ::Mesh &mesh = model.meshes[m];
+		for (int v = 0; v < mesh.vertexCount; ++v) {
+			Vector3f d = Vector3f(mesh.vertices[3 * v], mesh.vertices[3 * v + 1], mesh.vertices[3 * v + 2]) - mean;
+			covariance += d * d.transpose();
+		}
+	}
+
+	Eigen::SelfAdjointEigenSolver<Matrix3f> solver(covariance);
+	Matrix3f axes = solver.eigenvectors();
+	// Keep the axes right handed so they form a rotation.
+	if (axes.determinant() < 0.0f) {
+		axes.col(2) = -axes.col(2);
+	}
+
+	OrientedBox principal = enclose(model, axes);
+	OrientedBox aligned = enclose(model, Matrix3f::Identity());
+	OrientedBox box = principal.halfExtent.prod() < aligned.halfExtent.prod() ? principal : aligned;
+
+	box.center *= scale;
+	box.halfExtent *= scale;
+	return box;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <raylib.h>
+
+#include "quaternion.h"
+
+namespace rl
+{
+
+/**
+ * @class OrientedBox
+ * @brief Box with its own axes, used as the collision shape of a body.
+ */
+struct OrientedBox
+{
+	// Center of the box in the frame it is expressed in.
+	Vector3f center;
+	// Rotation of the box axes relative to the frame.
+	rl::Quaternion rotation;
+	// Half extents of the box along its axes.
+	Vector3f halfExtent;
+
+	/**
+	 * @brief Fits a box around all the vertices of the model meshes.
+	 * The axes are the principal axes of the vertex cloud. If the box aligned with the model axes is smaller,
+	 * it is used instead, which is the case for most of the box like models.
+	 *
+	 * @param model Loaded raylib model.
+	 * @param scale Scale the model is drawn with.
+	 * @return OrientedBox Box in the model frame.
+	 */
+	static OrientedBox fromModel(const ::Model &model, float scale);
+};
+
+}
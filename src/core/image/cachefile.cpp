@@ -0,0 +1,102 @@
+#include "cachefile.h"
+
+#include <format>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::optional<rl::cachefile::Stamp> rl::cachefile::stamp(const std::filesystem::path &path)
+{
+	struct stat info{};
+	if (::stat(path.c_str(), &info) != 0) {
+		return std::nullopt;
+	}
+	return Stamp{ uint64_t(info.st_size), int64_t(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec };
+}
+
+bool rl::cachefile::isCurrent(const Source &cached, const std::filesystem::path &source, const Stamp &sourceStamp)
+{
+	// The source was touched since the cache was written, it is still current if the content did not change.
+	if (cached.size != sourceStamp.size || cached.time != sourceStamp.time) {
+		return hashFile(source) == cached.hash;
+	}
+	return true;
+}
+
+std::optional<uint64_t> rl::cachefile::hashFile(const std::filesystem::path &path)
+{
+	Mapping mapping(path);
+	if (mapping.bytes().empty()) {
+		return std::nullopt;
+	}
+
+	uint64_t hash = 14695981039346656037ull;
+	for (uint8_t byte : mapping.bytes()) {
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+	return hash;
+}
+
+std::filesystem::path rl::cachefile::cachePath(const std::filesystem::path &directory, const std::filesystem::path &source,
+	std::string_view extension)
+{
+	std::error_code error;
+	auto absolute = std::filesystem::weakly_canonical(source, error);
+	size_t pathHash = std::hash<std::string>()((error ? source : absolute).string());
+	return directory / std::format("{}-{:016x}.{}", source.stem().string(), pathHash, extension);
+}
+
+rl::cachefile::Mapping::Mapping(const std::filesystem::path &path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat info{};
+	if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+		void *data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			m_data = static_cast<const uint8_t *>(data);
+			m_size = info.st_size;
+		}
+	}
+	::close(fd);
+}
+
+rl::cachefile::Mapping::~Mapping()
+{
+	if (m_data) {
+		::munmap(const_cast<uint8_t *>(m_data), m_size);
+	}
+}
+
+bool rl::cachefile::writeAtomically(const std::filesystem::path &path, const std::function<void(std::ofstream &)> &writer)
+{
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	auto temporary = path;
+	// Several threads may write the cache of the same source at once.
+	temporary += std::format(".{}-{}.tmp", ::getpid(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		writer(file);
+
+		if (!file.good()) {
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
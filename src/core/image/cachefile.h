@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include <raylib.h>
+
+/**
+ * Building blocks of the binary asset caches (rl::meshcache, rl::texturecache).
+ */
+namespace rl::cachefile
+{
+
+// Arrays are padded to this alignment so they can be read in place from the mapping.
+constexpr size_t ALIGNMENT = 8;
+
+inline size_t padded(size_t size)
+{
+	return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/**
+ * @brief Size and modification time of a file.
+ */
+struct Stamp
+{
+	uint64_t size = 0;
+	int64_t time = 0;
+};
+
+/**
+ * @brief Returns the size and modification time of the file, empty if it does not exist.
+ */
+std::optional<Stamp> stamp(const std::filesystem::path &path);
+
+/**
+ * @brief Source a cache file was written from, stored in the header of the cache file.
+ * The content hash is only compared if the size or modification time differ, so an unchanged source is not read at all.
+ */
+struct Source
+{
+	uint64_t size;
+	int64_t time;
+	uint64_t hash;
+};
+
+/**
+ * @brief Returns true if the source still has the content the cache file was written from.
+ *
+ * @param cached Source recorded in the cache file.
+ * @param source Path to the source file.
+ * @param sourceStamp Current size and modification time of the source file.
+ */
+bool isCurrent(const Source &cached, const std::filesystem::path &source, const Stamp &sourceStamp);
+
+/**
+ * @brief Returns the 64 bit FNV-1a hash of the file content, empty if the file cannot be read.
+ *
+ * @param path Path to the file.
+ */
+std::optional<uint64_t> hashFile(const std::filesystem::path &path);
+
+/**
+ * @brief Returns the path of the cache file of the source in the cache directory.
+ * The absolute source path is part of the name, so equally named sources from different directories do not clash.
+ *
+ * @param directory Directory of the cache files.
+ * @param source Path to the source file.
+ * @param extension Extension of the cache file, without the dot.
+ */
+std::filesystem::path cachePath(const std::filesystem::path &directory, const std::filesystem::path &source,
+	std::string_view extension);
+
+/**
+ * @brief Read only memory mapping of a whole file, unmapped on destruction.
+ */
+class Mapping
+{
+public:
+	explicit Mapping(const std::filesystem::path &path);
+	Mapping(const Mapping &) = delete;
+	Mapping &operator=(const Mapping &) = delete;
+	~Mapping();
+
+	std::span<const uint8_t> bytes() const { return { m_data, m_size }; }
+
+private:
+	const uint8_t *m_data = nullptr;
+	size_t m_size = 0;
+};
+
+/**
+ * @brief Sequential reader over the mapped cache file, fails instead of reading past its end.
+ */
+class Reader
+{
+public:
+	explicit Reader(std::span<const uint8_t> bytes)
+		: m_bytes(bytes)
+	{
+	}
+
+	template <typename T>
+	bool read(T &value)
+	{
+		if (m_offset + sizeof(T) > m_bytes.size()) {
+			return false;
+		}
+		std::memcpy(&value, m_bytes.data() + m_offset, sizeof(T));
+		m_offset += sizeof(T);
+		return true;
+	}
+
+	/**
+	 * @brief Copies an array out of the mapping into a buffer allocated by raylib, which frees it with the asset.
+	 */
+	template <typename T>
+	bool array(T *&target, size_t count)
+	{
+		size_t size = count * sizeof(T);
+		if (m_offset + size > m_bytes.size()) {
+			return false;
+		}
+		target = static_cast<T *>(MemAlloc(size));
+		std::memcpy(target, m_bytes.data() + m_offset, size);
+		m_offset += padded(size);
+		return true;
+	}
+
+private:
+	std::span<const uint8_t> m_bytes;
+	size_t m_offset = 0;
+};
+
+template <typename T>
+void write(std::ofstream &file, const T &value)
+{
+	file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+void writeArray(std::ofstream &file, const T *data, size_t count)
+{
+	static constexpr char zeros[ALIGNMENT] = {};
+	size_t size = count * sizeof(T);
+	file.write(reinterpret_cast<const char *>(data), size);
+	file.write(zeros, padded(size) - size);
+}
+
+/**
+ * @brief Writes the cache file through the writer.
+ * The file is written next to its final path and renamed, so a concurrent reader never sees half of it.
+ *
+ * @param path Final path of the cache file, its directory is created if needed.
+ * @param writer Writes the content into the opened file.
+ * @return bool True if the whole file was written.
+ */
+bool writeAtomically(const std::filesystem::path &path, const std::function<void(std::ofstream &)> &writer);
+
+}
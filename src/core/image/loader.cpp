@@ -6,9 +6,35 @@
 
 #include <nlohmann/json.hpp>
 
+#include "meshcache.h"
+#include "trace.h"
+
+#include <rlgl.h>
+
 using nlohmann::json;
 
-static size_t idCounter = 0;
+/**
+ * @brief Returns the paths the model is stored under in the loader, referencing the configuration.
+ */
+static std::tuple<const std::string &, const std::string &> modelKey(const rl::Model &model)
+{
+	return std::tie(model.modelPath, model.texturePath);
+}
+
+/**
+ * @brief Wraps the loaded model in a shared pointer that unloads it together with its texture.
+ */
+static std::shared_ptr<const ::Model> share(const ::Model &model)
+{
+	return std::shared_ptr<const ::Model>(new ::Model(model), [](const ::Model *model) {
+		// Models without a texture use the default texture shared by raylib, it must stay loaded.
+		if (model->materialCount > 0 && model->materials[0].maps[MATERIAL_MAP_DIFFUSE].texture.id != rlGetTextureIdDefault()) {
+			UnloadTexture(model->materials[0].maps[MATERIAL_MAP_DIFFUSE].texture);
+		}
+		UnloadModel(*model);
+		delete model;
+	});
+}
 
 rl::Model rl::Model::fromFile(const rl::Path &configPath)
 {
@@ -21,6 +47,7 @@ rl::Model rl::Model::fromFile(const rl::Path &configPath)
 	}
 
 	json jsonConfig = json::parse(file);
+	config.configPath = configPath.string();
 
 	// Read default types
 	config.modelPath = jsonConfig.value("modelPath", rl::Path("model.obj"));
@@ -67,6 +94,17 @@ rl::Model rl::Model::fromFile(const rl::Path &configPath)
 			{ inertiaValues[6], inertiaValues[7], inertiaValues[8] }
 		};
 	}
+	else if (auto properties = rl::meshcache::massProperties(config.modelPath); properties && properties->volume > 0.0f) {
+		// Without an explicit tensor the mass is spread uniformly over the volume of the mesh.
+		config.inertia = properties->inertiaFor(config.mass, config.scale);
+		config.inertiaFromMesh = true;
+		std::println("Computed inertia from the mesh: volume={:.4f} centerOfMass=({:.4f}, {:.4f}, {:.4f})",
+			properties->volume, properties->centerOfMass.x(), properties->centerOfMass.y(), properties->centerOfMass.z());
+	}
+	else {
+		config.inertia = Matrix3f::Identity() * config.mass;
+		std::println("[Warning]: No inertia given and it cannot be computed from the mesh: {}", config.modelPath);
+	}
 
 	std::println("Loaded configuration: modelPath={}\n texturePath={}\n position=({:.2f}, {:.2f}, {:.2f})\n "
 		"rotation=({:.2f}, {:.2f}, {:.2f})\n scale={:.2f}\n mass={:.2f}\n camera.position=({:.2f}, {:.2f}, {:.2f})\n "
@@ -87,8 +125,23 @@ rl::ImageLoader &rl::ImageLoader::instance()
 	return instance;
 }
 
-std::shared_ptr<::Model> rl::ImageLoader::loadModel(const rl::Model &model)
+std::shared_ptr<const ::Model> rl::ImageLoader::loadModel(const rl::Model &model)
 {
+	RL_TRACE_SCOPE("ImageLoader::loadModel");
+
+	// A model that is still loading in the background is finished right away.
+	auto pending = m_pending.find(modelKey(model));
+	if (pending != m_pending.end()) {
+		auto load = pending->second;
+		m_pending.erase(pending);
+		finish(*load);
+	}
+
+	auto it = m_images.find(modelKey(model));
+	if (it != m_images.end()) {
+		return it->second;
+	}
+
 	std::filesystem::path modelPath = model.modelPath;
 	bool modelExists = std::filesystem::exists(modelPath);
 	modelExists ?
@@ -101,55 +154,177 @@ std::shared_ptr<::Model> rl::ImageLoader::loadModel(const rl::Model &model)
 		std::print("Texture path exists: {}\n", texturePath.string()) :
 		std::print("Texture path does not exist: {}\n", texturePath.string());
 
-	auto hasher = std::hash<std::string>();
-	size_t hash = hasher(model.modelPath) ^ hasher(model.texturePath);
-
-	auto it = m_images.find(hash);
-	if (it != m_images.end()) {
-		auto m = *it->second;
-		hash ^= std::hash<size_t>()(idCounter++);
-		m_images[hash] = std::make_shared<::Model>(m);
-		return m_images[hash];
-	}
-
-	::Model m = LoadModel(model.modelPath.c_str());
+	::Model m = rl::meshcache::load(model.modelPath);
 	if (!IsModelValid(m)) {
 		std::print("[Error]: Model is not valid: {}\n", model.modelPath);
 		return nullptr;
 	}
 
 	std::print("Model materials count: {}\n", m.materialCount);
-	if (texturePath.empty() || !textureExists) {
-		for (int i = 0; i < m.materialCount; ++i) {
-			m.materials[i].maps[MATERIAL_MAP_DIFFUSE].color = BLUE;
-		}
-		std::print("[Warning]: No texture path provided or texture does not exist: {}\n", texturePath.string());
-	} else {
+	std::optional<Image> image;
+	if (!texturePath.empty() && textureExists) {
 		std::print("Loading texture from path: {}\n", texturePath.string());
-		Texture2D texture = LoadTexture(model.texturePath.c_str());  // Load model texture
-		m.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;			// Set map diffuse texture
+		image = rl::texturecache::parse(texturePath, m_textureSettings);
 	}
-	m_images[hash] = std::make_shared<::Model>(m);
-	return m_images[hash];
+
+	if (image) {
+		Texture2D texture = uploadTexture(*image, model.texturePath);
+		applyTexture(m, model, &texture);
+	}
+	else {
+		applyTexture(m, model, nullptr);
+	}
+	auto &shared = m_images[{ model.modelPath, model.texturePath }];
+	shared = share(m);
+	return shared;
 }
 
-void rl::ImageLoader::forceUnload(const rl::Model &model)
+void rl::ImageLoader::preload(const rl::Model &model, rl::JobSystem &jobs)
 {
-	auto hasher = std::hash<std::string>();
-	size_t hash = hasher(model.modelPath) ^ hasher(model.texturePath);
+	if (m_images.contains(modelKey(model)) || m_pending.contains(modelKey(model))) {
+		return;
+	}
+
+	auto pending = std::make_shared<PendingLoad>();
+	pending->config = model;
+	pending->jobs = &jobs;
+	pending->task = jobs.submit([pending, settings = m_textureSettings]() {
+		RL_TRACE_SCOPE("ImageLoader::preload");
+		pending->model = rl::meshcache::parse(pending->config.modelPath);
 
-	auto it = m_images.find(hash);
+		const auto &texturePath = pending->config.texturePath;
+		if (!texturePath.empty() && std::filesystem::exists(texturePath)) {
+			pending->image = rl::texturecache::parse(texturePath, settings);
+		}
+	});
+	m_pending[{ model.modelPath, model.texturePath }] = pending;
+}
+
+size_t rl::ImageLoader::uploadPending(std::chrono::duration<float> budget)
+{
+	RL_TRACE_SCOPE("ImageLoader::uploadPending");
+	auto start = std::chrono::steady_clock::now();
+
+	for (auto it = m_pending.begin(); it != m_pending.end();) {
+		auto load = it->second;
+		// Without worker threads nobody else runs the job, finish() executes it on this thread.
+		if (!load->task.done() && load->jobs->concurrency() > 1) {
+			++it;
+			continue;
+		}
+
+		it = m_pending.erase(it);
+		finish(*load);
+
+		if (std::chrono::steady_clock::now() - start >= budget) {
+			break;
+		}
+	}
+	return m_pending.size();
+}
+
+bool rl::ImageLoader::isLoaded(const rl::Model &model) const
+{
+	return m_images.contains(modelKey(model));
+}
+
+void rl::ImageLoader::finish(PendingLoad &pending)
+{
+	pending.jobs->wait(pending.task);
+
+	::Model m;
+	if (pending.model) {
+		m = *pending.model;
+		rl::meshcache::upload(m);
+	}
+	else {
+		m = rl::meshcache::load(pending.config.modelPath);
+	}
+
+	if (!IsModelValid(m)) {
+		std::print("[Error]: Model is not valid: {}\n", pending.config.modelPath);
+		if (pending.image) {
+			UnloadImage(*pending.image);
+		}
+		return;
+	}
+
+	if (pending.image) {
+		Texture2D texture = uploadTexture(*pending.image, pending.config.texturePath);
+		applyTexture(m, pending.config, &texture);
+	}
+	else {
+		applyTexture(m, pending.config, nullptr);
+	}
+	m_images[{ pending.config.modelPath, pending.config.texturePath }] = share(m);
+}
+
+Texture2D rl::ImageLoader::uploadTexture(Image &image, const std::string &path)
+{
+	Texture2D texture = LoadTextureFromImage(image);
+	UnloadImage(image);
+
+	if (texture.mipmaps > 1) {
+		SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
+	}
+
+	std::println("Texture {}: {}x{}, {} mip levels, {} KiB", path, texture.width, texture.height, texture.mipmaps,
+		rl::texturecache::memorySize(texture.width, texture.height, texture.mipmaps, texture.format) / 1024);
+	return texture;
+}
+
+void rl::ImageLoader::applyTexture(::Model &model, const rl::Model &config, const Texture2D *texture)
+{
+	if (texture == nullptr) {
+		for (int i = 0; i < model.materialCount; ++i) {
+			model.materials[i].maps[MATERIAL_MAP_DIFFUSE].color = BLUE;
+		}
+		std::print("[Warning]: No texture path provided or texture does not exist: {}\n", config.texturePath);
+		return;
+	}
+
+	model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = *texture;			// Set map diffuse texture
+}
+
+void rl::ImageLoader::evict(const rl::Model &model)
+{
+	auto it = m_images.find(modelKey(model));
 	if (it != m_images.end()) {
-		UnloadTexture(it->second->materials[0].maps[MATERIAL_MAP_DIFFUSE].texture);
-		UnloadModel(*it->second);
 		m_images.erase(it);
 	}
 }
 
-rl::ImageLoader::~ImageLoader()
+void rl::ImageLoader::setTextureSettings(const rl::TextureSettings &settings)
 {
-	for (auto& [hash, model] : m_images) {
-		UnloadTexture(model->materials[0].maps[MATERIAL_MAP_DIFFUSE].texture);
-		UnloadModel(*model);
+	m_textureSettings = settings;
+}
+
+size_t rl::ImageLoader::textureMemory() const
+{
+	size_t bytes = 0;
+	for (const auto &[key, model] : m_images) {
+		if (model->materialCount == 0) {
+			continue;
+		}
+
+		const Texture2D &texture = model->materials[0].maps[MATERIAL_MAP_DIFFUSE].texture;
+		if (texture.id != rlGetTextureIdDefault()) {
+			bytes += rl::texturecache::memorySize(texture.width, texture.height, texture.mipmaps, texture.format);
+		}
+	}
+	return bytes;
+}
+
+void rl::ImageLoader::release(const rl::Model &model)
+{
+	auto it = m_images.find(modelKey(model));
+	if (it != m_images.end() && it->second.use_count() == 1) {
+		m_images.erase(it);
 	}
 }
+
+rl::ImageLoader::~ImageLoader()
+{
+	// Models still held by objects are unloaded when the objects release them.
+	m_images.clear();
+}
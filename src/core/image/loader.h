@@ -1,12 +1,19 @@
 #pragma once
 
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <raylib.h>
 #include <string>
 #include <map>
+#include <tuple>
+#include <optional>
 #include <Eigen/Dense>
 
+#include "jobs.h"
+#include "quaternion.h"
+#include "texturecache.h"
+
 namespace rl
 {
 
@@ -62,6 +69,8 @@ struct Model
 	 */
 	static Model fromFile(const rl::Path &config);
 
+	// Configuration file the model was loaded from, empty if it was not loaded from a file.
+	std::string configPath;
 	std::string modelPath;
 	std::string texturePath;
 	Vector3 position;
@@ -74,11 +83,21 @@ struct Model
 	float dMoment;
 	Vector2 moment; // Min and max thrust
 	Matrix3f inertia;
+	// True if the inertia tensor was computed from the mesh, it is computed again when the mesh file changes.
+	bool inertiaFromMesh = false;
+	// Precision of the rigid body state, set for all the objects of a scenario by rl::Scenario.
+	rl::Precision precision = rl::Precision::Float;
 };
 
 /**
  * @class ImageLoader
  * @brief Singleton class for loading and managing 3D models and their textures.
+ *
+ * Models can be loaded synchronously by loadModel or streamed in by preload. Streamed models are parsed and their
+ * textures decoded on the worker threads, the main thread only uploads them to the GPU in uploadPending.
+ *
+ * Every model is loaded once and shared by all the objects using it. The shared model is immutable, each object
+ * keeps its own transform. The meshes and the texture are unloaded when the last reference to the model is released.
  */
 class ImageLoader
 {
@@ -92,27 +111,100 @@ public:
 
 	/**
 	 * @brief Loads a 3D model from the given rl::Model configuration.
+	 * Models already loaded are shared, not loaded again.
 	 *
 	 * @param model The rl::Model configuration containing model properties such as path, texture, position, rotation, scale,
 	 * and mass.
+	 * @return std::shared_ptr<const ::Model> Shared model, nullptr if it could not be loaded.
+	 */
+	std::shared_ptr<const ::Model> loadModel(const rl::Model &model);
+	/**
+	 * @brief Starts loading the model in the background. Returns immediately.
+	 * The CPU work (mesh parsing, texture decoding) runs on the job system, the GPU upload is done by uploadPending.
+	 *
+	 * @param model The rl::Model configuration of the model to be loaded.
+	 * @param jobs Job system the model is parsed on.
+	 */
+	void preload(const rl::Model &model, rl::JobSystem &jobs);
+	/**
+	 * @brief Uploads the background loaded models to the GPU. Main thread only.
+	 * At least one model is uploaded per call, so the loading always progresses.
+	 *
+	 * @param budget Time after which no further model is uploaded.
+	 * @return size_t Number of models still loading.
 	 */
-	std::shared_ptr<::Model> loadModel(const rl::Model &model);
+	size_t uploadPending(std::chrono::duration<float> budget);
 	/**
-	 * @brief Unloads a 3D model from the loader.
+	 * @brief Returns true if the model is uploaded, so loadModel returns it without loading.
 	 *
-	 * @param model The rl::Model configuration of the model to be unloaded.
+	 * @param model The rl::Model configuration of the model.
+	 */
+	bool isLoaded(const rl::Model &model) const;
+	/**
+	 * @brief Drops the loaded model even if objects still hold it, so the next loadModel loads it again.
+	 * Used when the model or texture file changed, the objects keep drawing the old model until they load it again.
+	 *
+	 * @param model The rl::Model configuration of the model to be evicted.
+	 */
+	void evict(const rl::Model &model);
+	/**
+	 * @brief Sets the preprocessing of the textures loaded from now on.
+	 *
+	 * @param settings Maximal size, mipmaps and pixel format of the textures.
+	 */
+	void setTextureSettings(const rl::TextureSettings &settings);
+	/**
+	 * @brief Returns the number of bytes the textures of the loaded models take in video memory.
 	 */
-	void forceUnload(const rl::Model &model);
+	size_t textureMemory() const;
+	/**
+	 * @brief Drops the loader reference to the model if no object holds it anymore, which unloads it.
+	 *
+	 * @param model The rl::Model configuration of the model to be released.
+	 */
+	void release(const rl::Model &model);
 
 	~ImageLoader();
 
 private:
+	/**
+	 * @brief Model loaded in the background, filled in by its job.
+	 */
+	struct PendingLoad
+	{
+		rl::Model config;
+		rl::JobSystem *jobs;
+		rl::JobSystem::Task task;
+		// Parsed model, empty if it has to be loaded by raylib on the main thread.
+		std::optional<::Model> model;
+		// Preprocessed texture, empty if there is none.
+		std::optional<Image> image;
+	};
+
+	// Models are keyed by both of their paths, looked up by a tuple of references without copying them.
+	using ModelKey = std::tuple<std::string, std::string>;
+
 	ImageLoader() = default;
 	ImageLoader(const ImageLoader &) = delete;
 	ImageLoader &operator=(const ImageLoader &) = delete;
 
+	/**
+	 * @brief Uploads the background loaded model and stores it under its paths. Main thread only.
+	 */
+	void finish(PendingLoad &pending);
+	/**
+	 * @brief Uploads the preprocessed image as a texture, frees the image and reports the texture memory. Main thread only.
+	 */
+	Texture2D uploadTexture(Image &image, const std::string &path);
+	/**
+	 * @brief Assigns the texture, or a plain color without one, to the model materials.
+	 */
+	void applyTexture(::Model &model, const rl::Model &config, const Texture2D *texture);
+
 private:
-	std::map<size_t, std::shared_ptr<::Model>> m_images;
+	std::map<ModelKey, std::shared_ptr<const ::Model>, std::less<>> m_images;
+	std::map<ModelKey, std::shared_ptr<PendingLoad>, std::less<>> m_pending;
+	rl::TextureSettings m_textureSettings;
 };
 
 }
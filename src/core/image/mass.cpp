@@ -0,0 +1,189 @@
+#include "mass.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "trace.h"
+
+namespace
+{
+
+/**
+ * @brief Polynomial terms of a single triangle edge coordinate shared by the integrals, see D. Eberly,
+ * Polyhedral Mass Properties (Revisited).
+ */
+struct Terms
+{
+	double f1, f2, f3;
+	double g0, g1, g2;
+};
+
+Terms terms(double w0, double w1, double w2)
+{
+	double temp0 = w0 + w1;
+	double temp1 = w0 * w0;
+	double temp2 = temp1 + w1 * temp0;
+
+	Terms t;
+	t.f1 = temp0 + w2;
+	t.f2 = temp2 + w2 * t.f1;
+	t.f3 = w0 * temp1 + w1 * temp2 + w2 * t.f2;
+	t.g0 = t.f2 + w0 * (t.f1 + w0);
+	t.g1 = t.f2 + w1 * (t.f1 + w1);
+	t.g2 = t.f2 + w2 * (t.f1 + w2);
+	return t;
+}
+
+// Number of triangles gathered into a block before the block is integrated.
+constexpr size_t BLOCK_SIZE = 256;
+// Independent partial sums kept per integral, one per lane of a 256 bit register of doubles.
+constexpr size_t LANES = 4;
+
+/**
+ * @brief Vertex coordinates of a block of triangles, one array per coordinate (x0, y0, z0, x1, ... z2).
+ */
+using TriangleBlock = std::array<std::array<double, BLOCK_SIZE>, 9>;
+/**
+ * @brief Partial sums of the integrals of 1, x, y, z, x^2, y^2, z^2, xy, yz and zx, one per lane.
+ */
+using Integrals = std::array<std::array<double, LANES>, 10>;
+
+/**
+ * @brief Adds the integrals of the triangles of the block to the partial sums.
+ * The lanes accumulate different triangles, so the lane loop vectorizes without reordering any sum. The count has
+ * to be a multiple of LANES, the padding triangles are degenerate and add nothing.
+ */
+void integrate(const TriangleBlock &block, size_t count, Integrals &integral)
+{
+	const auto &[x0s, y0s, z0s, x1s, y1s, z1s, x2s, y2s, z2s] = block;
+
+	for (size_t base = 0; base < count; base += LANES) {
+		for (size_t lane = 0; lane < LANES; ++lane) {
+			size_t t = base + lane;
+			double x0 = x0s[t], y0 = y0s[t], z0 = z0s[t];
+			double x1 = x1s[t], y1 = y1s[t], z1 = z1s[t];
+			double x2 = x2s[t], y2 = y2s[t], z2 = z2s[t];
+
+			// Normal of the triangle, scaled by twice its area.
+			double a1 = x1 - x0, b1 = y1 - y0, c1 = z1 - z0;
+			double a2 = x2 - x0, b2 = y2 - y0, c2 = z2 - z0;
+			double d0 = b1 * c2 - b2 * c1;
+			double d1 = a2 * c1 - a1 * c2;
+			double d2 = a1 * b2 - a2 * b1;
+
+			Terms x = terms(x0, x1, x2);
+			Terms y = terms(y0, y1, y2);
+			Terms z = terms(z0, z1, z2);
+
+			integral[0][lane] += d0 * x.f1;
+			integral[1][lane] += d0 * x.f2;
+			integral[2][lane] += d1 * y.f2;
+			integral[3][lane] += d2 * z.f2;
+			integral[4][lane] += d0 * x.f3;
+			integral[5][lane] += d1 * y.f3;
+			integral[6][lane] += d2 * z.f3;
+			integral[7][lane] += d0 * (y0 * x.g0 + y1 * x.g1 + y2 * x.g2);
+			integral[8][lane] += d1 * (z0 * y.g0 + z1 * y.g1 + z2 * y.g2);
+			integral[9][lane] += d2 * (x0 * z.g0 + x1 * z.g1 + x2 * z.g2);
+		}
+	}
+}
+
+}
+
+rl::MassProperties rl::MassProperties::fromModel(const ::Model &model)
+{
+	RL_TRACE_SCOPE("MassProperties::fromModel");
+
+	// The triangles are gathered into blocks of coordinate arrays, the indexed vertices are not contiguous.
+	TriangleBlock block{};
+	size_t count = 0;
+	Integrals partial{};
+	auto flush = [&]() {
+		size_t padded = (count + LANES - 1) / LANES * LANES;
+		for (auto &coordinate : block) {
+			std::fill(coordinate.begin() + count, coordinate.begin() + padded, 0.0);
+		}
+		integrate(block, padded, partial);
+		count = 0;
+	};
+
+	for (int m = 0; m < model.meshCount; ++m) {
+		const ::Mesh &mesh = model.meshes[m];
+		if (mesh.vertices == nullptr) {
+			continue;
+		}
+
+		for (int t = 0; t < mesh.triangleCount; ++t) {
+			for (int k = 0; k < 3; ++k) {
+				int index = mesh.indices ? mesh.indices[3 * t + k] : 3 * t + k;
+				const float *vertex = mesh.vertices + 3 * index;
+				block[3 * k][count] = vertex[0];
+				block[3 * k + 1][count] = vertex[1];
+				block[3 * k + 2][count] = vertex[2];
+			}
+			if (++count == BLOCK_SIZE) {
+				flush();
+			}
+		}
+	}
+	flush();
+
+	// Integrals of 1, x, y, z, x^2, y^2, z^2, xy, yz and zx over the volume.
+	std::array<double, 10> integral{};
+	for (size_t i = 0; i < integral.size(); ++i) {
+		for (double sum : partial[i]) {
+			integral[i] += sum;
+		}
+	}
+
+	constexpr std::array<double, 10> FACTORS = {
+		1.0 / 6.0, 1.0 / 24.0, 1.0 / 24.0, 1.0 / 24.0, 1.0 / 60.0, 1.0 / 60.0, 1.0 / 60.0, 1.0 / 120.0, 1.0 / 120.0, 1.0 / 120.0
+	};
+	// Inward facing triangles flip the sign of every integral.
+	double sign = integral[0] < 0.0 ? -1.0 : 1.0;
+	for (size_t i = 0; i < integral.size(); ++i) {
+		integral[i] *= FACTORS[i] * sign;
+	}
+
+	MassProperties properties{ 0.0f, Eigen::Vector3f::Zero(), Eigen::Matrix3f::Zero() };
+	double volume = integral[0];
+	if (volume <= 0.0) {
+		return properties;
+	}
+
+	double cx = integral[1] / volume;
+	double cy = integral[2] / volume;
+	double cz = integral[3] / volume;
+
+	// Second moments about the center of mass by the parallel axis theorem.
+	double xx = integral[5] + integral[6] - volume * (cy * cy + cz * cz);
+	double yy = integral[4] + integral[6] - volume * (cz * cz + cx * cx);
+	double zz = integral[4] + integral[5] - volume * (cx * cx + cy * cy);
+	double xy = -(integral[7] - volume * cx * cy);
+	double yz = -(integral[8] - volume * cy * cz);
+	double zx = -(integral[9] - volume * cz * cx);
+
+	properties.volume = volume;
+	properties.centerOfMass = Eigen::Vector3f(cx, cy, cz);
+	properties.inertia <<
+		xx, xy, zx,
+		xy, yy, yz,
+		zx, yz, zz;
+	return properties;
+}
+
+Eigen::Matrix3f rl::MassProperties::inertiaFor(float mass, float scale) const
+{
+	if (volume <= 0.0f) {
+		return Eigen::Matrix3f::Identity();
+	}
+
+	// The scaled volume grows with scale^3 and the second moments with scale^5, the density cancels the volume.
+	Eigen::Matrix3f center = inertia * (mass / volume * scale * scale);
+
+	// The body rotates about the model origin, the tensor is moved there by the parallel axis theorem.
+	Eigen::Vector3f offset = centerOfMass * scale;
+	return center + mass * (offset.squaredNorm() * Eigen::Matrix3f::Identity() - offset * offset.transpose());
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <raylib.h>
+
+namespace rl
+{
+
+/**
+ * @class MassProperties
+ * @brief Volume, center of mass and inertia tensor of the solid enclosed by the model meshes, at unit density.
+ */
+struct MassProperties
+{
+	float volume;
+	Eigen::Vector3f centerOfMass;
+	// Inertia tensor about the center of mass at unit density, in the model frame.
+	Eigen::Matrix3f inertia;
+
+	/**
+	 * @brief Integrates the mass properties over the triangles of the model meshes with the divergence theorem.
+	 * The meshes are expected to be closed, the orientation of their triangles does not matter as long as it is
+	 * consistent. The vertices must be in main memory.
+	 *
+	 * @param model Model with the meshes to be integrated.
+	 * @return MassProperties Mass properties of the model, zero volume if it has no triangles.
+	 */
+	static MassProperties fromModel(const ::Model &model);
+
+	/**
+	 * @brief Returns the inertia tensor of a body with uniformly distributed mass drawn with the scale.
+	 * The tensor is taken about the model origin, which the body rotates about, not about the center of mass.
+	 * The rigid body equations keep the mass and the inertia blocks apart, so the coupling of the linear and the
+	 * angular motion of an off center mass is not modelled.
+	 *
+	 * @param mass Mass of the body.
+	 * @param scale Scale the model is drawn with.
+	 */
+	Eigen::Matrix3f inertiaFor(float mass, float scale) const;
+};
+
+}
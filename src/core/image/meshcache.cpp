@@ -0,0 +1,308 @@
+#include "meshcache.h"
+
+#include "cachefile.h"
+#include "obj.h"
+#include "trace.h"
+
+#include <raymath.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <print>
+
+namespace
+{
+
+using rl::cachefile::Mapping;
+using rl::cachefile::Reader;
+using rl::cachefile::Source;
+using rl::cachefile::Stamp;
+using rl::cachefile::stamp;
+using rl::cachefile::write;
+using rl::cachefile::writeArray;
+
+constexpr char MAGIC[8] = { 'R', 'L', 'M', 'E', 'S', 'H', '\0', '\0' };
+// Bump whenever the layout of the cache file changes, older files are rebuilt.
+constexpr uint32_t VERSION = 2;
+
+enum MeshFlags : uint32_t
+{
+	HAS_NORMALS = 1 << 0,
+	HAS_TEXCOORDS = 1 << 1,
+	HAS_COLORS = 1 << 2,
+	HAS_INDICES = 1 << 3,
+};
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t meshCount;
+	Source source;
+	uint32_t materialCount;
+	// Mass properties of the meshes at unit density, see rl::MassProperties.
+	float volume;
+	float centerOfMass[3];
+	float inertia[9];
+};
+
+struct MeshHeader
+{
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+	uint32_t materialIndex;
+	uint32_t flags;
+};
+
+/**
+ * @brief Reads the header of a cache file, false if the file is stale or not a cache file of this version.
+ */
+bool readHeader(Reader &reader, FileHeader &header, const std::filesystem::path &source, const Stamp &sourceStamp)
+{
+	if (!reader.read(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+		|| header.meshCount == 0) {
+		return false;
+	}
+	return rl::cachefile::isCurrent(header.source, source, sourceStamp);
+}
+
+/**
+ * @brief Builds the model from a mapped cache file, empty if the file is stale or corrupted.
+ * The model still has to be uploaded by rl::meshcache::upload.
+ */
+std::optional<::Model> read(const std::filesystem::path &path, const std::filesystem::path &source, const Stamp &sourceStamp)
+{
+	Mapping mapping(path);
+	Reader reader(mapping.bytes());
+
+	FileHeader header;
+	if (!readHeader(reader, header, source, sourceStamp)) {
+		return std::nullopt;
+	}
+
+	::Model model{};
+	model.transform = MatrixIdentity();
+	model.meshCount = header.meshCount;
+	model.materialCount = std::max<uint32_t>(header.materialCount, 1);
+	model.meshes = static_cast<::Mesh *>(MemAlloc(model.meshCount * sizeof(::Mesh)));
+	model.meshMaterial = static_cast<int *>(MemAlloc(model.meshCount * sizeof(int)));
+	model.materials = static_cast<::Material *>(MemAlloc(model.materialCount * sizeof(::Material)));
+
+	bool valid = true;
+	for (int i = 0; i < model.materialCount; ++i) {
+		Color color = WHITE;
+		valid &= i >= int(header.materialCount) || reader.read(color);
+		model.materials[i].maps = static_cast<::MaterialMap *>(MemAlloc((MATERIAL_MAP_DIFFUSE + 1) * sizeof(::MaterialMap)));
+		model.materials[i].maps[MATERIAL_MAP_DIFFUSE].color = color;
+	}
+
+	for (int i = 0; valid && i < model.meshCount; ++i) {
+		MeshHeader meshHeader;
+		::Mesh &mesh = model.meshes[i];
+		if (!reader.read(meshHeader) || meshHeader.materialIndex >= uint32_t(model.materialCount)) {
+			valid = false;
+			break;
+		}
+
+		mesh.vertexCount = meshHeader.vertexCount;
+		mesh.triangleCount = meshHeader.triangleCount;
+		model.meshMaterial[i] = meshHeader.materialIndex;
+
+		valid &= reader.array(mesh.vertices, 3 * mesh.vertexCount);
+		if (meshHeader.flags & HAS_NORMALS) valid &= reader.array(mesh.normals, 3 * mesh.vertexCount);
+		if (meshHeader.flags & HAS_TEXCOORDS) valid &= reader.array(mesh.texcoords, 2 * mesh.vertexCount);
+		if (meshHeader.flags & HAS_COLORS) valid &= reader.array(mesh.colors, 4 * mesh.vertexCount);
+		if (meshHeader.flags & HAS_INDICES) valid &= reader.array(mesh.indices, 3 * mesh.triangleCount);
+	}
+
+	if (!valid) {
+		// Only the arrays read so far are allocated, the rest of the model was zero initialized.
+		rl::meshcache::unloadParsed(model);
+		return std::nullopt;
+	}
+	return model;
+}
+
+/**
+ * @brief Writes the meshes of the model into the cache file.
+ */
+bool write(const std::filesystem::path &path, const ::Model &model, const Source &source)
+{
+	return rl::cachefile::writeAtomically(path, [&](std::ofstream &file) {
+		FileHeader header{};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.meshCount = model.meshCount;
+		header.source = source;
+		header.materialCount = model.materialCount;
+
+		auto properties = rl::MassProperties::fromModel(model);
+		header.volume = properties.volume;
+		Eigen::Map<Eigen::Vector3f>(header.centerOfMass) = properties.centerOfMass;
+		Eigen::Map<Eigen::Matrix3f>(header.inertia) = properties.inertia;
+		write(file, header);
+
+		for (int i = 0; i < model.materialCount; ++i) {
+			write(file, model.materials[i].maps[MATERIAL_MAP_DIFFUSE].color);
+		}
+
+		for (int i = 0; i < model.meshCount; ++i) {
+			const ::Mesh &mesh = model.meshes[i];
+			MeshHeader meshHeader{
+				.vertexCount = uint32_t(mesh.vertexCount),
+				.triangleCount = uint32_t(mesh.triangleCount),
+				.materialIndex = uint32_t(model.meshMaterial ? model.meshMaterial[i] : 0),
+				.flags = (mesh.normals ? HAS_NORMALS : 0u) | (mesh.texcoords ? HAS_TEXCOORDS : 0u)
+					| (mesh.colors ? HAS_COLORS : 0u) | (mesh.indices ? HAS_INDICES : 0u),
+			};
+			write(file, meshHeader);
+
+			writeArray(file, mesh.vertices, 3 * mesh.vertexCount);
+			if (mesh.normals) writeArray(file, mesh.normals, 3 * mesh.vertexCount);
+			if (mesh.texcoords) writeArray(file, mesh.texcoords, 2 * mesh.vertexCount);
+			if (mesh.colors) writeArray(file, mesh.colors, 4 * mesh.vertexCount);
+			if (mesh.indices) writeArray(file, mesh.indices, 3 * mesh.triangleCount);
+		}
+	});
+}
+
+}
+
+std::optional<::Model> rl::meshcache::parse(const std::filesystem::path &source)
+{
+	RL_TRACE_SCOPE("meshcache::parse");
+
+	auto sourceStamp = stamp(source);
+	if (!sourceStamp) {
+		return std::nullopt;
+	}
+
+	auto cache = cachePath(source);
+	if (auto model = read(cache, source, *sourceStamp)) {
+		std::println("Loaded model from the mesh cache: {}", cache.string());
+		return model;
+	}
+
+	// Other formats are only understood by the raylib loader, which needs the GPU.
+	if (source.extension() != ".obj") {
+		return std::nullopt;
+	}
+
+	auto model = rl::obj::parse(source);
+	auto hash = rl::cachefile::hashFile(source);
+	if (model && hash) {
+		write(cache, *model, Source{ sourceStamp->size, sourceStamp->time, *hash })
+			? std::println("Written the mesh cache: {}", cache.string())
+			: std::println("[Warning]: Could not write the mesh cache: {}", cache.string());
+	}
+	return model;
+}
+
+void rl::meshcache::upload(::Model &model)
+{
+	RL_TRACE_SCOPE("meshcache::upload");
+
+	for (int i = 0; i < model.materialCount; ++i) {
+		::Material material = LoadMaterialDefault();
+		material.maps[MATERIAL_MAP_DIFFUSE].color = model.materials[i].maps[MATERIAL_MAP_DIFFUSE].color;
+		MemFree(model.materials[i].maps);
+		model.materials[i] = material;
+	}
+
+	for (int i = 0; i < model.meshCount; ++i) {
+		UploadMesh(&model.meshes[i], false);
+	}
+}
+
+void rl::meshcache::unloadParsed(::Model &model)
+{
+	for (int i = 0; model.meshes != nullptr && i < model.meshCount; ++i) {
+		::Mesh &mesh = model.meshes[i];
+		MemFree(mesh.vertices);
+		MemFree(mesh.texcoords);
+		MemFree(mesh.texcoords2);
+		MemFree(mesh.normals);
+		MemFree(mesh.tangents);
+		MemFree(mesh.colors);
+		MemFree(mesh.indices);
+		MemFree(mesh.animVertices);
+		MemFree(mesh.animNormals);
+		MemFree(mesh.boneIds);
+		MemFree(mesh.boneWeights);
+		MemFree(mesh.boneMatrices);
+	}
+	for (int i = 0; model.materials != nullptr && i < model.materialCount; ++i) {
+		MemFree(model.materials[i].maps);
+	}
+
+	MemFree(model.meshes);
+	MemFree(model.materials);
+	MemFree(model.meshMaterial);
+	MemFree(model.bones);
+	MemFree(model.bindPose);
+	model = ::Model{};
+}
+
+::Model rl::meshcache::load(const std::filesystem::path &source)
+{
+	RL_TRACE_SCOPE("meshcache::load");
+
+	if (auto model = parse(source)) {
+		upload(*model);
+		return *model;
+	}
+
+	::Model model = LoadModel(source.c_str());
+	auto sourceStamp = stamp(source);
+	auto hash = rl::cachefile::hashFile(source);
+	if (!sourceStamp || !hash || !IsModelValid(model) || model.boneCount > 0) {
+		return model;
+	}
+
+	auto cache = cachePath(source);
+	write(cache, model, Source{ sourceStamp->size, sourceStamp->time, *hash })
+		? std::println("Written the mesh cache: {}", cache.string())
+		: std::println("[Warning]: Could not write the mesh cache: {}", cache.string());
+	return model;
+}
+
+std::optional<rl::MassProperties> rl::meshcache::massProperties(const std::filesystem::path &source)
+{
+	RL_TRACE_SCOPE("meshcache::massProperties");
+
+	auto sourceStamp = stamp(source);
+	if (!sourceStamp) {
+		return std::nullopt;
+	}
+
+	{
+		Mapping mapping(cachePath(source));
+		Reader reader(mapping.bytes());
+
+		FileHeader header;
+		if (readHeader(reader, header, source, *sourceStamp)) {
+			return rl::MassProperties{
+				.volume = header.volume,
+				.centerOfMass = Eigen::Map<const Eigen::Vector3f>(header.centerOfMass),
+				.inertia = Eigen::Map<const Eigen::Matrix3f>(header.inertia),
+			};
+		}
+	}
+
+	// Parsing writes the cache, the properties are computed right away instead of reading it back.
+	auto model = parse(source);
+	if (!model) {
+		return std::nullopt;
+	}
+
+	auto properties = rl::MassProperties::fromModel(*model);
+	// The meshes were never uploaded, releasing them needs neither the main thread nor a GL context.
+	unloadParsed(*model);
+	return properties;
+}
+
+std::filesystem::path rl::meshcache::cachePath(const std::filesystem::path &source)
+{
+	return rl::cachefile::cachePath(MESH_CACHE_PATH, source, "rlmesh");
+}
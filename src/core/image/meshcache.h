@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include <raylib.h>
+
+#include "mass.h"
+
+namespace rl::meshcache
+{
+
+/**
+ * @brief Reads the model from the binary mesh cache, or parses the OBJ source and writes the cache.
+ * Does not touch the GPU, so it can run on a worker thread. The model is drawable after rl::meshcache::upload.
+ *
+ * @param source Path to the source model file.
+ * @return std::optional<::Model> Model with the meshes in main memory, empty if the source is not cached
+ * and is not an OBJ file.
+ */
+std::optional<::Model> parse(const std::filesystem::path &source);
+
+/**
+ * @brief Uploads the meshes of a parsed model to the GPU and finishes its materials. Main thread only.
+ *
+ * @param model Model returned by rl::meshcache::parse.
+ */
+void upload(::Model &model);
+
+/**
+ * @brief Frees the memory of a parsed model that was never uploaded.
+ * Unlike UnloadModel it makes no GL calls, so it runs on any thread and before the window is created.
+ *
+ * @param model Model returned by rl::meshcache::parse, or a partially built one.
+ */
+void unloadParsed(::Model &model);
+
+/**
+ * @brief Loads a model through the binary mesh cache.
+ *
+ * The first load parses the source (OBJ files by rl::obj::parse, other formats by raylib) and writes its vertex,
+ * normal, texture coordinate, color and index arrays into a binary cache file together with the hash of the source
+ * content. The following loads map the cache file into memory and only copy the arrays out of it. If the size or
+ * modification time of the source changed, the content hash is compared and a stale cache is rebuilt. Models that cannot be cached (animated
+ * ones) are loaded by raylib directly. Only the diffuse colors of the materials are cached, textures are
+ * assigned by the caller.
+ *
+ * @param source Path to the source model file.
+ * @return ::Model Loaded model, uploaded to the GPU.
+ */
+::Model load(const std::filesystem::path &source);
+
+/**
+ * @brief Returns the mass properties of the source model at unit density.
+ * They are computed when the cache is written and read from its header afterwards, so only an uncached source is
+ * parsed. Does not touch the GPU.
+ *
+ * @param source Path to the source model file.
+ * @return std::optional<rl::MassProperties> Mass properties, empty if the source is not cached and is not an OBJ file.
+ */
+std::optional<rl::MassProperties> massProperties(const std::filesystem::path &source);
+
+/**
+ * @brief Returns the path of the cache file of the source model.
+ *
+ * @param source Path to the source model file.
+ */
+std::filesystem::path cachePath(const std::filesystem::path &source);
+
+}
@@ -0,0 +1,252 @@
+#include "obj.h"
+
+#include "trace.h"
+
+#include <raymath.h>
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+/**
+ * @brief Corner of a face, indices into the position, texture coordinate and normal lists, -1 if missing.
+ */
+struct Corner
+{
+	int position;
+	int texcoord;
+	int normal;
+};
+
+/**
+ * @brief Triangles of the faces using a single material.
+ */
+struct Group
+{
+	std::vector<std::array<Corner, 3>> triangles;
+	bool texcoords = true;
+	bool normals = true;
+};
+
+std::string_view trim(std::string_view text)
+{
+	size_t begin = text.find_first_not_of(" \t\r");
+	if (begin == std::string_view::npos) {
+		return {};
+	}
+	return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+/**
+ * @brief Splits the first whitespace separated token off the text.
+ */
+std::string_view token(std::string_view &text)
+{
+	text = trim(text);
+	size_t end = text.find_first_of(" \t");
+	auto result = text.substr(0, end);
+	text = end == std::string_view::npos ? std::string_view{} : text.substr(end);
+	return result;
+}
+
+float number(std::string_view &text)
+{
+	auto value = token(text);
+	float result = 0.0f;
+	std::from_chars(value.data(), value.data() + value.size(), result);
+	return result;
+}
+
+/**
+ * @brief Resolves a one based, possibly negative (relative to the end) OBJ index, -1 if missing or invalid.
+ */
+int resolve(std::string_view text, size_t count)
+{
+	int index = 0;
+	if (text.empty() || std::from_chars(text.data(), text.data() + text.size(), index).ec != std::errc()) {
+		return -1;
+	}
+	index = index < 0 ? int(count) + index : index - 1;
+	return index >= 0 && size_t(index) < count ? index : -1;
+}
+
+std::string readFile(const std::filesystem::path &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+/**
+ * @brief Reads the diffuse colors of the materials in the MTL file.
+ */
+void readMaterials(const std::filesystem::path &path, std::map<std::string, int, std::less<>> &indices,
+	std::vector<Color> &colors)
+{
+	std::string content = readFile(path);
+	std::string_view rest = content;
+	int current = -1;
+
+	while (!rest.empty()) {
+		size_t end = rest.find('\n');
+		std::string_view line = rest.substr(0, end);
+		rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+
+		auto keyword = token(line);
+		if (keyword == "newmtl") {
+			std::string name(trim(line));
+			auto [it, inserted] = indices.try_emplace(name, int(colors.size()));
+			if (inserted) {
+				colors.push_back(WHITE);
+			}
+			current = it->second;
+		}
+		else if (keyword == "Kd" && current >= 0) {
+			float r = number(line), g = number(line), b = number(line);
+			colors[current] = Color{ (unsigned char)(r * 255.0f), (unsigned char)(g * 255.0f), (unsigned char)(b * 255.0f), 255 };
+		}
+	}
+}
+
+template <typename T>
+T *allocate(size_t count)
+{
+	return static_cast<T *>(MemAlloc(count * sizeof(T)));
+}
+
+}
+
+std::optional<::Model> rl::obj::parse(const std::filesystem::path &path)
+{
+	RL_TRACE_SCOPE("obj::parse");
+
+	std::string content = readFile(path);
+	if (content.empty()) {
+		return std::nullopt;
+	}
+
+	std::vector<std::array<float, 3>> positions;
+	std::vector<std::array<float, 2>> texcoords;
+	std::vector<std::array<float, 3>> normals;
+
+	// Material 0 is the default one used by faces before any usemtl.
+	std::map<std::string, int, std::less<>> materialIndices;
+	std::vector<Color> materialColors = { WHITE };
+	std::map<int, Group> groups;
+	int material = 0;
+
+	std::vector<Corner> face;
+	std::string_view rest = content;
+	while (!rest.empty()) {
+		size_t end = rest.find('\n');
+		std::string_view line = rest.substr(0, end);
+		rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+
+		auto keyword = token(line);
+		if (keyword == "v") {
+			positions.push_back({ number(line), number(line), number(line) });
+		}
+		else if (keyword == "vt") {
+			texcoords.push_back({ number(line), number(line) });
+		}
+		else if (keyword == "vn") {
+			normals.push_back({ number(line), number(line), number(line) });
+		}
+		else if (keyword == "f") {
+			face.clear();
+			for (auto vertex = token(line); !vertex.empty(); vertex = token(line)) {
+				// position/texcoord/normal, the last two are optional.
+				size_t first = vertex.find('/');
+				size_t second = first == std::string_view::npos ? first : vertex.find('/', first + 1);
+				face.push_back(Corner{
+					.position = resolve(vertex.substr(0, first), positions.size()),
+					.texcoord = first == std::string_view::npos ? -1
+						: resolve(vertex.substr(first + 1, second - first - 1), texcoords.size()),
+					.normal = second == std::string_view::npos ? -1 : resolve(vertex.substr(second + 1), normals.size()),
+				});
+			}
+
+			auto &group = groups[material];
+			for (size_t i = 2; i < face.size(); ++i) {
+				std::array<Corner, 3> triangle{ face[0], face[i - 1], face[i] };
+				if (triangle[0].position < 0 || triangle[1].position < 0 || triangle[2].position < 0) {
+					continue;
+				}
+				for (const auto &corner : triangle) {
+					group.texcoords &= corner.texcoord >= 0;
+					group.normals &= corner.normal >= 0;
+				}
+				group.triangles.push_back(triangle);
+			}
+		}
+		else if (keyword == "usemtl") {
+			std::string name(trim(line));
+			auto [it, inserted] = materialIndices.try_emplace(name, int(materialColors.size()));
+			if (inserted) {
+				materialColors.push_back(WHITE);
+			}
+			material = it->second;
+		}
+		else if (keyword == "mtllib") {
+			readMaterials(path.parent_path() / std::string(trim(line)), materialIndices, materialColors);
+		}
+	}
+
+	std::erase_if(groups, [](const auto &group) { return group.second.triangles.empty(); });
+	if (groups.empty()) {
+		return std::nullopt;
+	}
+
+	::Model model{};
+	model.transform = MatrixIdentity();
+	model.meshCount = groups.size();
+	model.meshes = allocate<::Mesh>(model.meshCount);
+	model.meshMaterial = allocate<int>(model.meshCount);
+	model.materialCount = materialColors.size();
+	model.materials = allocate<::Material>(model.materialCount);
+
+	// Only the diffuse map is filled, rl::meshcache::upload replaces the maps by the full default material.
+	for (int i = 0; i < model.materialCount; ++i) {
+		model.materials[i].maps = allocate<::MaterialMap>(MATERIAL_MAP_DIFFUSE + 1);
+		model.materials[i].maps[MATERIAL_MAP_DIFFUSE].color = materialColors[i];
+	}
+
+	int meshIndex = 0;
+	for (const auto &[materialIndex, group] : groups) {
+		::Mesh &mesh = model.meshes[meshIndex];
+		model.meshMaterial[meshIndex++] = materialIndex;
+
+		mesh.vertexCount = 3 * group.triangles.size();
+		mesh.triangleCount = group.triangles.size();
+		mesh.vertices = allocate<float>(3 * mesh.vertexCount);
+		mesh.texcoords = group.texcoords ? allocate<float>(2 * mesh.vertexCount) : nullptr;
+		mesh.normals = group.normals ? allocate<float>(3 * mesh.vertexCount) : nullptr;
+
+		size_t vertex = 0;
+		for (const auto &triangle : group.triangles) {
+			for (const auto &corner : triangle) {
+				std::memcpy(mesh.vertices + 3 * vertex, positions[corner.position].data(), 3 * sizeof(float));
+				if (mesh.texcoords) {
+					mesh.texcoords[2 * vertex] = texcoords[corner.texcoord][0];
+					mesh.texcoords[2 * vertex + 1] = 1.0f - texcoords[corner.texcoord][1];
+				}
+				if (mesh.normals) {
+					std::memcpy(mesh.normals + 3 * vertex, normals[corner.normal].data(), 3 * sizeof(float));
+				}
+				++vertex;
+			}
+		}
+	}
+
+	return model;
+}
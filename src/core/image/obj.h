@@ -0,0 +1,25 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include <raylib.h>
+
+namespace rl::obj
+{
+
+/**
+ * @brief Parses a Wavefront OBJ file and its MTL materials into a model without touching the GPU,
+ * so it can run on any thread.
+ *
+ * The faces are triangulated and split into one non-indexed mesh per material, like the raylib OBJ loader does.
+ * Texture coordinates are flipped vertically to match raylib. Only the diffuse colors of the materials are read,
+ * textures are assigned by the caller. The meshes have to be uploaded and the materials finished by
+ * rl::meshcache::upload on the main thread before the model is drawn.
+ *
+ * @param path Path to the OBJ file.
+ * @return std::optional<::Model> Parsed model, empty if the file cannot be read or has no faces.
+ */
+std::optional<::Model> parse(const std::filesystem::path &path);
+
+}
@@ -0,0 +1,158 @@
+#include "texturecache.h"
+
+#include "cachefile.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <print>
+
+namespace
+{
+
+using rl::cachefile::Source;
+using rl::cachefile::Stamp;
+
+constexpr char MAGIC[8] = { 'R', 'L', 'T', 'E', 'X', '\0', '\0', '\0' };
+// Bump whenever the layout of the cache file or the preprocessing changes, older files are rebuilt.
+constexpr uint32_t VERSION = 2;
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	Source source;
+	// Settings the texture was preprocessed with, a cache written with different ones is rebuilt.
+	int32_t maxSize;
+	int32_t mipmapsEnabled;
+	int32_t targetFormat;
+	// Layout of the pixel data following the header.
+	int32_t width;
+	int32_t height;
+	int32_t mipmaps;
+	int32_t format;
+	int32_t padding;
+};
+
+/**
+ * @brief Builds the image from the cache file, empty if the file is stale, corrupted or preprocessed differently.
+ */
+std::optional<Image> read(const std::filesystem::path &path, const std::filesystem::path &source, const Stamp &sourceStamp,
+	const rl::TextureSettings &settings)
+{
+	rl::cachefile::Mapping mapping(path);
+	rl::cachefile::Reader reader(mapping.bytes());
+
+	FileHeader header;
+	if (!reader.read(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+		|| header.maxSize != settings.maxSize || header.mipmapsEnabled != settings.mipmaps
+		|| header.targetFormat != int32_t(settings.format)
+		|| !rl::cachefile::isCurrent(header.source, source, sourceStamp)) {
+		return std::nullopt;
+	}
+
+	Image image{};
+	image.width = header.width;
+	image.height = header.height;
+	image.mipmaps = header.mipmaps;
+	image.format = header.format;
+
+	uint8_t *data = nullptr;
+	if (!reader.array(data, rl::texturecache::memorySize(image.width, image.height, image.mipmaps, image.format))) {
+		return std::nullopt;
+	}
+	image.data = data;
+	return image;
+}
+
+bool write(const std::filesystem::path &path, const Image &image, const Source &source, const rl::TextureSettings &settings)
+{
+	return rl::cachefile::writeAtomically(path, [&](std::ofstream &file) {
+		FileHeader header{};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.source = source;
+		header.maxSize = settings.maxSize;
+		header.mipmapsEnabled = settings.mipmaps;
+		header.targetFormat = int32_t(settings.format);
+		header.width = image.width;
+		header.height = image.height;
+		header.mipmaps = image.mipmaps;
+		header.format = image.format;
+		rl::cachefile::write(file, header);
+
+		rl::cachefile::writeArray(file, static_cast<const uint8_t *>(image.data),
+			rl::texturecache::memorySize(image.width, image.height, image.mipmaps, image.format));
+	});
+}
+
+/**
+ * @brief Downscales, converts and mipmaps the decoded source image as configured.
+ */
+void preprocess(Image &image, const rl::TextureSettings &settings)
+{
+	int largest = std::max(image.width, image.height);
+	if (settings.maxSize > 0 && largest > settings.maxSize) {
+		float factor = float(settings.maxSize) / largest;
+		ImageResize(&image, std::max(1, int(image.width * factor)), std::max(1, int(image.height * factor)));
+	}
+
+	// ImageFormat drops the mipmaps of the image and generates them again, so they are generated once, after the
+	// conversion. raylib filters every level from the converted pixels expanded back to RGBA8.
+	ImageFormat(&image, int(settings.format));
+	if (settings.mipmaps) {
+		ImageMipmaps(&image);
+	}
+}
+
+}
+
+std::optional<Image> rl::texturecache::parse(const std::filesystem::path &source, const TextureSettings &settings)
+{
+	RL_TRACE_SCOPE("texturecache::parse");
+
+	auto sourceStamp = rl::cachefile::stamp(source);
+	if (!sourceStamp) {
+		return std::nullopt;
+	}
+
+	auto cache = cachePath(source);
+	if (auto image = read(cache, source, *sourceStamp, settings)) {
+		std::println("Loaded texture from the texture cache: {}", cache.string());
+		return image;
+	}
+
+	Image image = LoadImage(source.c_str());
+	if (!IsImageValid(image)) {
+		return std::nullopt;
+	}
+
+	size_t decoded = memorySize(image.width, image.height, image.mipmaps, image.format);
+	preprocess(image, settings);
+	std::println("Preprocessed texture {}: {} KiB decoded, {} KiB with {} mip levels at {}x{}", source.string(),
+		decoded / 1024, memorySize(image.width, image.height, image.mipmaps, image.format) / 1024, image.mipmaps,
+		image.width, image.height);
+
+	auto hash = rl::cachefile::hashFile(source);
+	if (hash) {
+		write(cache, image, Source{ sourceStamp->size, sourceStamp->time, *hash }, settings)
+			? std::println("Written the texture cache: {}", cache.string())
+			: std::println("[Warning]: Could not write the texture cache: {}", cache.string());
+	}
+	return image;
+}
+
+size_t rl::texturecache::memorySize(int width, int height, int mipmaps, int format)
+{
+	size_t size = 0;
+	for (int level = 0; level < std::max(mipmaps, 1); ++level) {
+		size += GetPixelDataSize(std::max(width >> level, 1), std::max(height >> level, 1), format);
+	}
+	return size;
+}
+
+std::filesystem::path rl::texturecache::cachePath(const std::filesystem::path &source)
+{
+	return rl::cachefile::cachePath(TEXTURE_CACHE_PATH, source, "rltex");
+}
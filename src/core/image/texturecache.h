@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+
+#include <raylib.h>
+
+namespace rl
+{
+
+/**
+ * @brief Uncompressed pixel formats the textures can be kept in, the values are the raylib pixel formats.
+ * raylib cannot compress images, compressing the textures on load is not supported.
+ */
+enum class TextureFormat
+{
+	Rgba8 = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+	Rgb8 = PIXELFORMAT_UNCOMPRESSED_R8G8B8,
+	Rgb565 = PIXELFORMAT_UNCOMPRESSED_R5G6B5,
+	Rgba5551 = PIXELFORMAT_UNCOMPRESSED_R5G5B5A1,
+	Rgba4444 = PIXELFORMAT_UNCOMPRESSED_R4G4B4A4,
+};
+
+/**
+ * @class TextureSettings
+ * @brief Preprocessing applied to the textures when they are loaded.
+ */
+struct TextureSettings
+{
+	// Largest width or height of a texture, larger ones are downscaled keeping their aspect ratio. 0 keeps the full size.
+	int maxSize = 1024;
+	// Generates the mipmap chain, the texture is then sampled with trilinear filtering.
+	bool mipmaps = true;
+	// Pixel format the texture is kept in, TextureFormat::Rgb565 halves the memory of opaque textures.
+	TextureFormat format = TextureFormat::Rgba8;
+};
+
+}
+
+namespace rl::texturecache
+{
+
+/**
+ * @brief Reads the preprocessed texture from the binary texture cache, or decodes and preprocesses the source image
+ * and writes the cache. Does not touch the GPU, so it can run on a worker thread.
+ *
+ * The source is downscaled to the maximal size, converted to the pixel format and its mipmaps are generated as
+ * configured by the settings. The cache is rebuilt when the source content or the settings change.
+ *
+ * @param source Path to the source image file.
+ * @param settings Preprocessing of the texture.
+ * @return std::optional<Image> Preprocessed image, empty if the source cannot be decoded.
+ */
+std::optional<Image> parse(const std::filesystem::path &source, const TextureSettings &settings);
+
+/**
+ * @brief Returns the number of bytes the pixels of all the mip levels take.
+ *
+ * @param width Width of the base level.
+ * @param height Height of the base level.
+ * @param mipmaps Number of mip levels including the base level.
+ * @param format Pixel format.
+ */
+size_t memorySize(int width, int height, int mipmaps, int format);
+
+/**
+ * @brief Returns the path of the cache file of the source image.
+ *
+ * @param source Path to the source image file.
+ */
+std::filesystem::path cachePath(const std::filesystem::path &source);
+
+}
@@ -0,0 +1,55 @@
+#include "input.h"
+
+#include <algorithm>
+#include <raylib.h>
+
+rl::InputState::InputState(std::initializer_list<int> keys)
+{
+	for (int key : keys) {
+		m_down.set(key);
+	}
+}
+
+rl::InputState rl::InputState::sample()
+{
+	InputState state;
+	for (size_t key = 1; key < MAX_KEYS; ++key) {
+		state.m_down[key] = IsKeyDown(key);
+		state.m_pressed[key] = IsKeyPressed(key);
+	}
+	return state;
+}
+
+bool rl::InputState::down(int key) const
+{
+	return m_down.test(key);
+}
+
+bool rl::InputState::pressed(int key) const
+{
+	return m_pressed.test(key);
+}
+
+rl::InputScript &rl::InputScript::hold(size_t steps, const InputState &state)
+{
+	m_segments.push_back(Segment{ length() + steps, state });
+	return *this;
+}
+
+const rl::InputState &rl::InputScript::at(size_t step) const
+{
+	if (length() == 0) {
+		return m_idle;
+	}
+
+	step %= length();
+	auto it = std::upper_bound(m_segments.begin(), m_segments.end(), step, [](size_t s, const Segment &segment) {
+		return s < segment.end;
+	});
+	return it->state;
+}
+
+size_t rl::InputScript::length() const
+{
+	return m_segments.empty() ? 0 : m_segments.back().end;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace rl
+{
+
+/**
+ * @class InputState
+ * @brief Immutable snapshot of the keyboard state.
+ *
+ * The snapshot is sampled from raylib once per frame on the main thread. Controllers only read the
+ * snapshot, so they can run concurrently and do not depend on a window being open.
+ */
+class InputState
+{
+public:
+	// Number of key codes covered by the snapshot, matches raylib MAX_KEYBOARD_KEYS.
+	static constexpr size_t MAX_KEYS = 512;
+
+	/**
+	 * @brief Constructs a snapshot with no keys held down.
+	 */
+	InputState() = default;
+	/**
+	 * @brief Constructs a snapshot with the given keys held down.
+	 *
+	 * @param keys raylib key codes of the held keys.
+	 */
+	InputState(std::initializer_list<int> keys);
+
+	/**
+	 * @brief Samples the current keyboard state from raylib.
+	 */
+	static InputState sample();
+
+	/**
+	 * @brief Returns true if the key is held down.
+	 *
+	 * @param key raylib key code.
+	 */
+	bool down(int key) const;
+	/**
+	 * @brief Returns true if the key has been pressed since the previous snapshot.
+	 *
+	 * @param key raylib key code.
+	 */
+	bool pressed(int key) const;
+
+private:
+	std::bitset<MAX_KEYS> m_down;
+	std::bitset<MAX_KEYS> m_pressed;
+};
+
+/**
+ * @class InputScript
+ * @brief Command buffer of input snapshots, one per simulation step.
+ *
+ * The script is built from segments of steps during which a set of keys is held. It drives headless runs
+ * with the same input the controllers get from the keyboard.
+ */
+class InputScript
+{
+public:
+	/**
+	 * @brief Appends a segment with the keys held down for the given number of steps.
+	 *
+	 * @param steps Length of the segment in simulation steps.
+	 * @param state Input snapshot used during the segment.
+	 * @return InputScript& Reference to the script to chain the segments.
+	 */
+	InputScript &hold(size_t steps, const InputState &state);
+
+	/**
+	 * @brief Returns the input of the step. The script repeats once the last segment ends.
+	 *
+	 * @param step Index of the simulation step.
+	 */
+	const InputState &at(size_t step) const;
+
+	/**
+	 * @brief Returns the number of steps of the whole script.
+	 */
+	size_t length() const;
+
+private:
+	struct Segment
+	{
+		// Step one past the end of the segment.
+		size_t end;
+		InputState state;
+	};
+
+	std::vector<Segment> m_segments;
+	InputState m_idle;
+};
+
+}
@@ -0,0 +1,266 @@
+#include "jobs.h"
+
+#include "trace.h"
+
+// Queue owned by the calling thread, set for the worker threads of a job system.
+thread_local const rl::JobSystem *t_owner = nullptr;
+thread_local size_t t_queue = 0;
+
+bool rl::JobSystem::Task::done() const
+{
+	return !m_state || m_state->done.load(std::memory_order_acquire);
+}
+
+rl::JobSystem::JobSystem(size_t threads)
+{
+	for (size_t i = 0; i <= threads; ++i) {
+		m_queues.push_back(std::make_unique<Worker>());
+	}
+
+	for (size_t i = 0; i < threads; ++i) {
+		auto helper = std::make_shared<TaskState>();
+		helper->job = [this]() {
+			runChunks(m_loop);
+		};
+		m_loopHelpers.push_back(std::move(helper));
+	}
+
+	for (size_t i = 1; i <= threads; ++i) {
+		m_threads.emplace_back([this, i]() {
+			workerLoop(i);
+		});
+	}
+}
+
+rl::JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard lock(m_sleepMutex);
+		m_running = false;
+	}
+	m_wakeUp.notify_all();
+
+	for (auto &thread : m_threads) {
+		thread.join();
+	}
+}
+
+size_t rl::JobSystem::concurrency() const
+{
+	return m_threads.size() + 1;
+}
+
+rl::JobSystem::Task rl::JobSystem::submit(std::function<void()> job, std::initializer_list<Task> dependencies)
+{
+	auto task = std::make_shared<TaskState>();
+	task->job = std::move(job);
+
+	// The extra pending count keeps the task from being scheduled while the dependencies are registered.
+	task->pending = dependencies.size() + 1;
+	for (const auto &dependency : dependencies) {
+		if (!dependency.m_state) {
+			task->pending--;
+			continue;
+		}
+
+		std::lock_guard lock(dependency.m_state->mutex);
+		if (dependency.m_state->done) {
+			task->pending--;
+		}
+		else {
+			dependency.m_state->dependents.push_back(task);
+		}
+	}
+
+	if (--task->pending == 0) {
+		schedule(task);
+	}
+	return Task(task);
+}
+
+void rl::JobSystem::wait(const Task &task)
+{
+	size_t self = queueIndex();
+	while (!task.done()) {
+		if (!runOne(self)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void rl::JobSystem::distribute(size_t begin, size_t end, size_t grain, const LoopBody &body)
+{
+	size_t chunks = (end - begin + grain - 1) / grain;
+	size_t helpers = std::min(chunks - 1, m_threads.size());
+
+	// A loop started while another one runs, from a chunk of it or from another thread, cannot take the shared
+	// helpers. It submits helpers of its own, which allocates.
+	if (m_loopBusy.exchange(true, std::memory_order_acquire)) {
+		Loop loop{ .body = &body, .begin = begin, .end = end, .grain = grain, .chunks = chunks };
+		std::vector<Task> tasks;
+		tasks.reserve(helpers);
+		for (size_t i = 0; i < helpers; ++i) {
+			tasks.push_back(submit([&loop]() { runChunks(loop); }));
+		}
+
+		runChunks(loop);
+
+		// The helpers reference the loop state on this stack frame, all of them have to finish.
+		for (const auto &task : tasks) {
+			wait(task);
+		}
+		return;
+	}
+
+	m_loop.body = &body;
+	m_loop.begin = begin;
+	m_loop.end = end;
+	m_loop.grain = grain;
+	m_loop.chunks = chunks;
+	m_loop.next.store(0, std::memory_order_relaxed);
+
+	// Queueing the helpers publishes the loop state to the workers that pick them up.
+	for (size_t i = 0; i < helpers; ++i) {
+		m_loopHelpers[i]->done.store(false, std::memory_order_relaxed);
+		schedule(m_loopHelpers[i]);
+	}
+
+	runChunks(m_loop);
+
+	// The loop body lives on the stack of the caller, all the helpers have to finish before it returns.
+	for (size_t i = 0; i < helpers; ++i) {
+		wait(Task(m_loopHelpers[i]));
+	}
+	m_loopBusy.store(false, std::memory_order_release);
+}
+
+void rl::JobSystem::runChunks(Loop &loop)
+{
+	RL_TRACE_SCOPE("parallelFor");
+	// Every participating thread keeps claiming chunks until the range is exhausted,
+	// so a slow chunk does not hold up the others.
+	for (size_t chunk = loop.next.fetch_add(1); chunk < loop.chunks; chunk = loop.next.fetch_add(1)) {
+		size_t chunkBegin = loop.begin + chunk * loop.grain;
+		(*loop.body)(chunkBegin, std::min(chunkBegin + loop.grain, loop.end));
+	}
+}
+
+void rl::JobSystem::schedule(std::shared_ptr<TaskState> task)
+{
+	auto &queue = *m_queues[queueIndex()];
+	{
+		std::lock_guard lock(queue.mutex);
+		queue.tasks.pushBack(std::move(task));
+	}
+	m_queued.fetch_add(1, std::memory_order_release);
+
+	// Taking the sleep mutex makes sure a worker that is about to sleep sees the queued task.
+	{
+		std::lock_guard lock(m_sleepMutex);
+	}
+	m_wakeUp.notify_one();
+}
+
+bool rl::JobSystem::runOne(size_t self)
+{
+	std::shared_ptr<TaskState> task;
+
+	// Own queue first, newest task to keep its data in cache.
+	{
+		auto &queue = *m_queues[self];
+		std::lock_guard lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.popBack();
+		}
+	}
+
+	// Steal the oldest task of another queue.
+	for (size_t i = 1; !task && i < m_queues.size(); ++i) {
+		auto &queue = *m_queues[(self + i) % m_queues.size()];
+		std::lock_guard lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.popFront();
+		}
+	}
+
+	if (!task) {
+		return false;
+	}
+
+	m_queued.fetch_sub(1, std::memory_order_relaxed);
+	execute(task);
+	return true;
+}
+
+void rl::JobSystem::execute(const std::shared_ptr<TaskState> &task)
+{
+	task->job();
+
+	std::vector<std::shared_ptr<TaskState>> dependents;
+	{
+		std::lock_guard lock(task->mutex);
+		task->done.store(true, std::memory_order_release);
+		dependents.swap(task->dependents);
+	}
+
+	for (auto &dependent : dependents) {
+		if (--dependent->pending == 0) {
+			schedule(std::move(dependent));
+		}
+	}
+}
+
+void rl::JobSystem::workerLoop(size_t self)
+{
+	t_owner = this;
+	t_queue = self;
+
+	while (true) {
+		if (runOne(self)) {
+			continue;
+		}
+
+		std::unique_lock lock(m_sleepMutex);
+		m_wakeUp.wait(lock, [this]() {
+			return m_queued.load(std::memory_order_acquire) > 0 || !m_running;
+		});
+		if (!m_running) {
+			return;
+		}
+	}
+}
+
+size_t rl::JobSystem::queueIndex() const
+{
+	return t_owner == this ? t_queue : 0;
+}
+
+void rl::JobSystem::TaskQueue::pushBack(std::shared_ptr<TaskState> task)
+{
+	if (m_size == m_tasks.size()) {
+		// Unwrap the ring into one twice as large.
+		std::vector<std::shared_ptr<TaskState>> tasks(std::max<size_t>(2 * m_tasks.size(), 16));
+		for (size_t i = 0; i < m_size; ++i) {
+			tasks[i] = std::move(m_tasks[(m_head + i) % m_tasks.size()]);
+		}
+		m_tasks = std::move(tasks);
+		m_head = 0;
+	}
+
+	m_tasks[(m_head + m_size) % m_tasks.size()] = std::move(task);
+	++m_size;
+}
+
+std::shared_ptr<rl::JobSystem::TaskState> rl::JobSystem::TaskQueue::popBack()
+{
+	--m_size;
+	return std::move(m_tasks[(m_head + m_size) % m_tasks.size()]);
+}
+
+std::shared_ptr<rl::JobSystem::TaskState> rl::JobSystem::TaskQueue::popFront()
+{
+	auto task = std::move(m_tasks[m_head]);
+	m_head = (m_head + 1) % m_tasks.size();
+	--m_size;
+	return task;
+}
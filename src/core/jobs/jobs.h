@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rl
+{
+
+/**
+ * @class JobSystem
+ * @brief Persistent pool of worker threads executing tasks and parallel loops.
+ *
+ * Every worker owns a task queue. Workers pop tasks from the back of their own queue and, when it runs
+ * dry, steal from the front of the other queues. Threads waiting for a task or a parallel loop to finish
+ * help executing queued tasks instead of blocking, so the calling thread is a worker as well.
+ *
+ * Parallel loops do not allocate. The loop function is referenced instead of copied, and the helper tasks of a loop
+ * are created once with the workers and reused by every loop.
+ */
+class JobSystem
+{
+	struct TaskState;
+
+public:
+	/**
+	 * @class Task
+	 * @brief Handle of a submitted task, used to wait for it or to depend on it.
+	 */
+	class Task
+	{
+		friend class JobSystem;
+
+	public:
+		Task() = default;
+
+		/**
+		 * @brief Returns true when the task has finished executing.
+		 */
+		bool done() const;
+
+	private:
+		explicit Task(std::shared_ptr<TaskState> state)
+			: m_state(std::move(state))
+		{
+		}
+
+		std::shared_ptr<TaskState> m_state;
+	};
+
+	/**
+	 * @brief Starts the worker threads.
+	 *
+	 * @param threads Number of worker threads besides the calling thread. Defaults to the number of
+	 * hardware threads minus one.
+	 */
+	explicit JobSystem(size_t threads = std::max(std::thread::hardware_concurrency(), 1u) - 1);
+	JobSystem(const JobSystem &) = delete;
+	JobSystem &operator=(const JobSystem &) = delete;
+	~JobSystem();
+
+	/**
+	 * @brief Returns the number of threads executing the jobs, including the calling thread.
+	 */
+	size_t concurrency() const;
+
+	/**
+	 * @brief Submits a task that is executed once all its dependencies have finished.
+	 *
+	 * @param job Function to execute.
+	 * @param dependencies Tasks that need to finish before the job is started.
+	 * @return Task Handle of the submitted task.
+	 */
+	Task submit(std::function<void()> job, std::initializer_list<Task> dependencies = {});
+
+	/**
+	 * @brief Blocks until the task has finished. The calling thread executes queued tasks meanwhile.
+	 *
+	 * @param task Task to wait for.
+	 */
+	void wait(const Task &task);
+
+	/**
+	 * @brief Calls the function on chunks of the range [begin, end) in parallel and waits for all of them.
+	 * Ranges that fit a single chunk are executed directly on the calling thread without any dispatch.
+	 *
+	 * @param begin First index of the range.
+	 * @param end Index one past the end of the range.
+	 * @param grain Number of indices processed by a single call of the function.
+	 * @param function Function called with the [begin, end) bounds of every chunk.
+	 */
+	template <typename Function>
+	void parallelFor(size_t begin, size_t end, size_t grain, Function &&function)
+	{
+		if (begin >= end) {
+			return;
+		}
+
+		grain = std::max<size_t>(grain, 1);
+		if (end - begin <= grain || m_threads.empty()) {
+			function(begin, end);
+			return;
+		}
+		distribute(begin, end, grain, LoopBody(function));
+	}
+
+private:
+	/**
+	 * @class LoopBody
+	 * @brief Non owning reference to the function of a parallel loop, the function stays on the stack of the caller.
+	 */
+	class LoopBody
+	{
+	public:
+		template <typename Function>
+		explicit LoopBody(Function &function)
+			: m_function(const_cast<void *>(static_cast<const void *>(std::addressof(function))))
+			, m_call([](void *function, size_t begin, size_t end) { (*static_cast<Function *>(function))(begin, end); })
+		{
+		}
+
+		void operator()(size_t begin, size_t end) const { m_call(m_function, begin, end); }
+
+	private:
+		void *m_function;
+		void (*m_call)(void *function, size_t begin, size_t end);
+	};
+
+	/**
+	 * @brief Shared state of a parallel loop, every participating thread claims its chunks from it.
+	 */
+	struct Loop
+	{
+		const LoopBody *body = nullptr;
+		size_t begin = 0;
+		size_t end = 0;
+		size_t grain = 1;
+		size_t chunks = 0;
+		// Index of the next chunk to be claimed.
+		std::atomic<size_t> next{ 0 };
+	};
+
+	struct TaskState
+	{
+		std::function<void()> job;
+		// Number of dependencies that have not finished yet.
+		std::atomic<size_t> pending{ 0 };
+		std::atomic<bool> done{ false };
+		// Tasks waiting for this task to finish.
+		std::mutex mutex;
+		std::vector<std::shared_ptr<TaskState>> dependents;
+	};
+
+	/**
+	 * @class TaskQueue
+	 * @brief Ring buffer of queued tasks, it only allocates when it holds more tasks than ever before.
+	 */
+	class TaskQueue
+	{
+	public:
+		bool empty() const { return m_size == 0; }
+		void pushBack(std::shared_ptr<TaskState> task);
+		std::shared_ptr<TaskState> popBack();
+		std::shared_ptr<TaskState> popFront();
+
+	private:
+		std::vector<std::shared_ptr<TaskState>> m_tasks;
+		size_t m_head = 0;
+		size_t m_size = 0;
+	};
+
+	struct Worker
+	{
+		std::mutex mutex;
+		TaskQueue tasks;
+	};
+
+	/**
+	 * @brief Runs the chunks of the range [begin, end) on the helpers and the calling thread, grain < end - begin.
+	 */
+	void distribute(size_t begin, size_t end, size_t grain, const LoopBody &body);
+	/**
+	 * @brief Claims and executes chunks of the loop until all of them are claimed.
+	 */
+	static void runChunks(Loop &loop);
+
+	/**
+	 * @brief Pushes a task whose dependencies have finished to a worker queue and wakes a worker up.
+	 */
+	void schedule(std::shared_ptr<TaskState> task);
+	/**
+	 * @brief Executes a single queued task, returns false when all the queues are empty.
+	 *
+	 * @param self Index of the queue of the executing thread.
+	 */
+	bool runOne(size_t self);
+	/**
+	 * @brief Executes the task and schedules its dependents that have no pending dependencies left.
+	 */
+	void execute(const std::shared_ptr<TaskState> &task);
+	/**
+	 * @brief Main loop of the worker threads.
+	 */
+	void workerLoop(size_t self);
+	/**
+	 * @brief Returns the index of the queue owned by the calling thread.
+	 */
+	size_t queueIndex() const;
+
+private:
+	// Queue 0 belongs to the threads outside of the pool, the rest to the workers.
+	std::vector<std::unique_ptr<Worker>> m_queues;
+	std::vector<std::thread> m_threads;
+	// Number of tasks in all the queues.
+	std::atomic<size_t> m_queued{ 0 };
+	std::atomic<bool> m_running{ true };
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeUp;
+
+	// Loop of the parallelFor in flight and its helper tasks, one per worker, reused by every loop.
+	Loop m_loop;
+	std::atomic<bool> m_loopBusy{ false };
+	std::vector<std::shared_ptr<TaskState>> m_loopHelpers;
+};
+
+}
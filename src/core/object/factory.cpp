@@ -0,0 +1,47 @@
+#include "factory.h"
+
+#include <print>
+
+rl::ObjectFactory &rl::ObjectFactory::instance()
+{
+	static ObjectFactory instance;
+	return instance;
+}
+
+void rl::ObjectFactory::add(const std::string &type, Factory factory)
+{
+	m_factories[type] = std::move(factory);
+	m_pools.erase(type);
+}
+
+bool rl::ObjectFactory::contains(const std::string &type) const
+{
+	return m_factories.contains(type);
+}
+
+rl::Object::Ptr rl::ObjectFactory::create(const std::string &type, const rl::Model &model) const
+{
+	auto it = m_factories.find(type);
+	if (it == m_factories.end()) {
+		std::println("[Error]: Unknown object type: {}", type);
+		return nullptr;
+	}
+	return it->second(model);
+}
+
+void rl::ObjectFactory::reserve(const std::string &type, size_t count) const
+{
+	auto it = m_pools.find(type);
+	if (it != m_pools.end()) {
+		it->second(count);
+	}
+}
+
+std::unique_ptr<rl::UpdateLane> rl::ObjectFactory::lane(std::type_index type, rl::Precision precision) const
+{
+	auto it = m_lanes.find(type);
+	if (it == m_lanes.end()) {
+		return std::make_unique<rl::TypedLane<rl::Object>>(precision);
+	}
+	return it->second(precision);
+}
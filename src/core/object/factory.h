@@ -0,0 +1,104 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+
+#include "lane.h"
+#include "object.h"
+
+namespace rl
+{
+
+/**
+ * @class ObjectFactory
+ * @brief Singleton registry of the object types that can be spawned by name, e.g. from a scenario file.
+ *
+ * Types registered by add<T> are also indexed by their C++ type, the application keeps their objects in a
+ * rl::TypedLane of their own and updates them without the virtual dispatch. New vehicle types only need to be
+ * registered, the core does not know them.
+ */
+class ObjectFactory
+{
+public:
+	using Factory = std::function<rl::Object::Ptr(const rl::Model &)>;
+	using LaneFactory = std::function<std::unique_ptr<rl::UpdateLane>(rl::Precision)>;
+	using PoolReserve = std::function<void(size_t)>;
+
+	/**
+	 * @brief Returns the singleton instance of ObjectFactory.
+	 *
+	 * @return ObjectFactory& Reference to the singleton instance.
+	 */
+	static ObjectFactory &instance();
+
+	/**
+	 * @brief Registers the object type under the name, replacing any type registered under it before.
+	 *
+	 * @param type Name of the object type.
+	 * @param factory Function creating the object from its model configuration.
+	 */
+	void add(const std::string &type, Factory factory);
+	/**
+	 * @brief Registers the final object type T under the name, constructed from its model configuration.
+	 * Its objects are updated in a rl::TypedLane<T>.
+	 *
+	 * @param type Name of the object type.
+	 */
+	template <typename T>
+	void add(const std::string &type)
+	{
+		static_assert(std::is_final_v<T>, "Only the calls on final types are resolved statically");
+		add(type, [](const rl::Model &model) { return rl::makeObject<T>(model); });
+		m_lanes[std::type_index(typeid(T))] = [](rl::Precision precision) -> std::unique_ptr<rl::UpdateLane> {
+			return std::make_unique<rl::TypedLane<T>>(precision);
+		};
+		m_pools[type] = [](size_t count) {
+			auto &pool = rl::Pool<T>::instance();
+			pool.reserve(pool.size() + count);
+		};
+	}
+	/**
+	 * @brief Returns true if an object type is registered under the name.
+	 */
+	bool contains(const std::string &type) const;
+	/**
+	 * @brief Creates an object of the registered type.
+	 *
+	 * @param type Name of the object type.
+	 * @param model Model configuration of the object.
+	 * @return rl::Object::Ptr Created object, nullptr if no such type is registered.
+	 */
+	rl::Object::Ptr create(const std::string &type, const rl::Model &model) const;
+	/**
+	 * @brief Reserves the rl::Pool of the type for more objects, so creating them in bulk does not allocate.
+	 * Types registered without add<T> have no pool, they are ignored.
+	 *
+	 * @param type Name of the object type.
+	 * @param count Number of objects about to be created.
+	 */
+	void reserve(const std::string &type, size_t count) const;
+	/**
+	 * @brief Creates an empty update lane for the objects of the C++ type and body precision.
+	 * Types not registered by add<T> get a lane with the virtual calls.
+	 *
+	 * @param type Dynamic type of the objects.
+	 * @param precision Precision of the bodies of the objects.
+	 */
+	std::unique_ptr<rl::UpdateLane> lane(std::type_index type, rl::Precision precision) const;
+
+private:
+	ObjectFactory() = default;
+	ObjectFactory(const ObjectFactory &) = delete;
+	ObjectFactory &operator=(const ObjectFactory &) = delete;
+
+private:
+	std::map<std::string, Factory> m_factories;
+	std::map<std::type_index, LaneFactory> m_lanes;
+	std::map<std::string, PoolReserve> m_pools;
+};
+
+}
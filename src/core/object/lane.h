@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+#include "input.h"
+#include "object.h"
+
+namespace rl
+{
+
+/**
+ * @class UpdateLane
+ * @brief Homogeneous array of the objects of a single type and body precision, updated in one pass.
+ * The type and the body store are resolved once per lane and step instead of once per object, see rl::TypedLane.
+ */
+class UpdateLane
+{
+public:
+	virtual ~UpdateLane() = default;
+
+	/**
+	 * @brief Adds the object to the lane, the object has to be of the type of the lane.
+	 * The lane only refers to the object, it has to be removed from the lane before it is destroyed.
+	 *
+	 * @param object Object to be added.
+	 * @param handle Handle the application identifies the object with.
+	 * @return size_t Slot of the object in the lane.
+	 */
+	virtual size_t add(rl::Object *object, rl::PoolHandle handle) = 0;
+	/**
+	 * @brief Removes the object in the slot, the last object of the lane moves into it.
+	 *
+	 * @param slot Slot of the object to be removed.
+	 * @return rl::PoolHandle Handle of the object moved into the slot, an invalid handle if the removed object
+	 * was the last one.
+	 */
+	virtual rl::PoolHandle remove(size_t slot) = 0;
+	/**
+	 * @brief Returns the number of objects in the lane.
+	 */
+	virtual size_t size() const = 0;
+	/**
+	 * @brief Updates the torques of the objects with indices in range [begin, end).
+	 * Disjoint ranges can be updated concurrently.
+	 *
+	 * @param begin Index of the first object to update.
+	 * @param end Index one past the last object to update.
+	 * @param input Input snapshot of the current step.
+	 * @param step Controller scaling of the current step.
+	 */
+	virtual void update(size_t begin, size_t end, const rl::InputState &input, const rl::ControlStep &step) = 0;
+};
+
+/**
+ * @class TypedLane
+ * @brief Lane of the objects of the type T.
+ *
+ * For a final T the getTorque calls of the update loop are resolved statically, they are direct calls the compiler
+ * can inline. Vehicle types declare the lane as an extern template in their header and instantiate it in their
+ * source file, so the loop is compiled next to the controller definition. rl::TypedLane<rl::Object> holds the
+ * objects of the types that are not registered by rl::ObjectFactory::add<T>, their calls stay virtual.
+ * All the objects of a lane have the precision of the lane, the torques are set in its store directly.
+ */
+template <typename T>
+class TypedLane final : public UpdateLane
+{
+	static_assert(std::is_base_of_v<rl::Object, T>, "Lanes hold rl::Object types");
+
+public:
+	/**
+	 * @brief Constructs an empty lane for the objects with the body precision.
+	 */
+	explicit TypedLane(rl::Precision precision)
+		: m_precision(precision)
+	{
+	}
+
+	size_t add(rl::Object *object, rl::PoolHandle handle) override
+	{
+		assert(object->precision() == m_precision && "The object belongs to the lane of its precision");
+		m_objects.push_back(static_cast<T *>(object));
+		m_handles.push_back(handle);
+		return m_objects.size() - 1;
+	}
+
+	rl::PoolHandle remove(size_t slot) override
+	{
+		rl::PoolHandle moved;
+		if (slot + 1 < m_objects.size()) {
+			m_objects[slot] = m_objects.back();
+			m_handles[slot] = m_handles.back();
+			moved = m_handles[slot];
+		}
+		m_objects.pop_back();
+		m_handles.pop_back();
+		return moved;
+	}
+
+	size_t size() const override
+	{
+		return m_objects.size();
+	}
+
+	void update(size_t begin, size_t end, const rl::InputState &input, const rl::ControlStep &step) override;
+
+private:
+	rl::Precision m_precision;
+	std::vector<T *> m_objects;
+	// Handles of the objects, only read when an object is removed.
+	std::vector<rl::PoolHandle> m_handles;
+};
+
+template <typename T>
+void TypedLane<T>::update(size_t begin, size_t end, const rl::InputState &input, const rl::ControlStep &step)
+{
+	rl::withBodyStore(m_precision, [&](auto &store) {
+		for (size_t i = begin; i < end; ++i) {
+			T &object = *m_objects[i];
+			store.setTorque(object.body(), object.getTorque(input, step));
+		}
+	});
+}
+
+}
@@ -1,124 +1,188 @@
 #include "object.h"
 
+#include <algorithm>
+#include <cmath>
 #include <raymath.h>
 
+rl::ControlStep rl::ControlStep::at(float dt)
+{
+	const float periods = dt * rl::CONTROL_RATE;
+	return rl::ControlStep{
+		.periods = periods,
+		.thrustDecay = std::pow(0.99f, periods),
+		.momentDecay = std::pow(0.96f, periods),
+	};
+}
+
 rl::Object::Object(const rl::Model &model)
 	: m_rlModel(model)
 	, m_model(nullptr)
-	, m_invMrb(Matrix6f::Zero())
-	, m_inertiaMatrix(Matrix3f::Zero())
-	, m_feedbackTau(Vector6f::Zero())
+	, m_transform(MatrixIdentity())
 	, m_tau(Vector6f::Zero())
-	, m_quat(rl::Quaternion::fromEuler(model.rotation))
+	, m_renderPosition(model.position)
+	, m_renderQuat(rl::Quaternion::fromEuler(model.rotation))
+	, m_precision(model.precision)
 {
-	std::println("Model path {}", m_rlModel.modelPath);
-	std::println("Texture path {}", m_rlModel.texturePath);
-
-	m_inertiaMatrix = m_rlModel.inertia;
+	m_body = bodyStore([&](auto &store) { return store.add(model.position, m_renderQuat, model.mass, model.inertia); });
+}
 
-	m_invMrb.block<3, 3>(0, 0) = Eigen::Matrix3f::Identity() * model.mass;
-	m_invMrb.block<3, 3>(3, 3) = m_inertiaMatrix;
-	m_invMrb = m_invMrb.inverse();
+void rl::ObjectDeleter::operator()(Object *object) const
+{
+	if (destroy) {
+		destroy(object);
+	}
+	else {
+		delete object;
+	}
 }
 
 rl::Object::~Object()
 {
-	rl::ImageLoader::instance().forceUnload(m_rlModel);
+	bodyStore([this](auto &store) { store.remove(m_body); });
+	m_model.reset();
+	rl::ImageLoader::instance().release(m_rlModel);
 }
 
 void rl::Object::loadModel()
 {
 	m_model = rl::ImageLoader::instance().loadModel(m_rlModel);
+	if (!m_model || m_model->meshCount == 0) {
+		return;
+	}
+
+	// The collision shape is fitted once, the model transform only holds the rotation the body applies itself.
+	auto box = rl::OrientedBox::fromModel(*m_model, m_rlModel.scale);
+	bodyStore([&](auto &store) { store.setBounds(m_body, box.center, box.rotation, box.halfExtent); });
 }
 
-void rl::Object::update(float dt)
+void rl::Object::reconfigure(const rl::Model &model)
 {
-	auto tau = getTorque();
-	/* std::cout << "Torque: " << tau << std::endl; */
-	auto nu = rigidBody(tau, dt);
-	auto [p, q] = kinematics(nu, dt);
+	bool assetsChanged = model.modelPath != m_rlModel.modelPath || model.texturePath != m_rlModel.texturePath
+		|| model.scale != m_rlModel.scale;
+
+	// The configured pose is only where the object spawned, the body carries its live pose.
+	rl::Model previous = m_rlModel;
+	m_rlModel = model;
+	m_rlModel.position = previous.position;
+	m_rlModel.rotation = previous.rotation;
+	// The body stays in the store it was created in.
+	m_rlModel.precision = m_precision;
+	bodyStore([&](auto &store) { store.setMass(m_body, model.mass, model.inertia); });
+
+	if (assetsChanged && m_model) {
+		m_model.reset();
+		rl::ImageLoader::instance().release(previous);
+		loadModel();
+	}
+}
 
-	// Tranformation matrix for rotations
-	transform(q);
-	move(p);
+void rl::Object::update(const rl::InputState &input, const rl::ControlStep &step)
+{
+	applyTorque(getTorque(input, step));
 }
 
-rl::Quaternion rl::Object::rotation() const
+void rl::Object::applyTorque(const Vector6f &tau)
 {
-	return rl::Quaternion::fromRlRotMatrix(m_model->transform);
+	bodyStore([&](auto &store) { store.setTorque(m_body, tau); });
 }
 
-void rl::Object::draw() const
+void rl::Object::interpolate(float alpha)
 {
-	// Draw 3d model with texture
-	DrawModel(*m_model, m_rlModel.position, m_rlModel.scale, WHITE);
+	bodyStore([&](const auto &store) {
+		m_renderPosition = Vector3Lerp(store.previousPosition(m_body), store.position(m_body), alpha);
+		m_renderQuat = rl::Quaternion::slerp(store.previousRotation(m_body), store.rotation(m_body), alpha);
+	});
 }
 
-rl::Model rl::Object::rlModel() const
+Vector3 rl::Object::position() const
 {
-	return m_rlModel;
+	return bodyStore([this](const auto &store) { return store.position(m_body); });
 }
 
-std::shared_ptr<::Model> rl::Object::model() const
+rl::Quaternion rl::Object::rotation() const
 {
-	return m_model;
+	return bodyStore([this](const auto &store) { return store.rotation(m_body); });
 }
 
-Vector6f rl::Object::rigidBody(Vector6f &tau, float dt)
+Vector3 rl::Object::renderPosition() const
 {
-	tau -= m_feedbackTau;
+	return m_renderPosition;
+}
 
-	Vector6f nu_dot = m_invMrb * tau;
-	Vector6f nu = nu_dot * dt;
+rl::Quaternion rl::Object::renderRotation() const
+{
+	return m_renderQuat;
+}
 
-	Vector3f v = nu.head<3>();
-	Vector3f omega = nu.tail<3>();
+bool rl::Object::loaded() const
+{
+	return m_model != nullptr;
+}
 
-	auto tmp = m_inertiaMatrix * omega;
+void rl::Object::draw() const
+{
+	// The model is still streaming in, draw a placeholder in its place. Until the model is loaded the body collides
+	// as the unit box rl::BasicBodyStore::add gives it, the placeholder shows that box.
+	if (!m_model) {
+		DrawCubeWires(m_renderPosition, 1.0f, 1.0f, 1.0f, GRAY);
+		return;
+	}
 
-	auto pt1 = omega.cross(m_rlModel.mass * v);
-	auto pt2 = -1 * tmp.cross(omega);
-	m_feedbackTau.head<3>() = pt1;
-	m_feedbackTau.tail<3>() = pt2;
+	// The copy is shallow, it shares the meshes and materials and only carries the instance transform.
+	::Model instance = *m_model;
+	instance.transform = m_transform;
 
-	return nu;
+	// Draw 3d model with texture
+	DrawModel(instance, m_renderPosition, m_rlModel.scale, WHITE);
 }
 
-std::pair<Eigen::Vector3f, rl::Quaternion> rl::Object::kinematics(const Vector6f &nu, float dt)
+rl::BodyStore::Handle rl::Object::body() const
 {
-	constexpr int L = 100;
-	Vector3f p;
-	rl::Quaternion omega_bar(nu[3], nu[4], nu[5], 0);
-
-	// Position
-	rl::Quaternion p_dot = m_quat.rotate(nu.head<3>());
-	p = p_dot.data().head<3>() * dt;
+	return m_body;
+}
 
-	// Rotation
-	rl::Quaternion q_dot = 0.5 * (m_quat * omega_bar);
-	m_quat = m_quat + q_dot * dt;
+rl::Precision rl::Object::precision() const
+{
+	return m_precision;
+}
 
-	/* std::println("transpose: {}, {}, {}, {}", transpose[0], transpose[1], transpose[2], transpose[3]); */
-	m_quat += L * (1 - m_quat.ctranspose().dot(m_quat)) * m_quat;
-	m_quat.normalize();
+const rl::Model &rl::Object::rlModel() const
+{
+	return m_rlModel;
+}
 
-	return { p, m_quat };
+std::shared_ptr<const ::Model> rl::Object::model() const
+{
+	return m_model;
 }
 
 void rl::Object::transform(const rl::Quaternion &quat)
 {
-	m_model->transform = quat.toRlRotMatrix();
+	m_transform = quat.toRlRotMatrix();
 }
 
-void rl::Object::move(const Eigen::Vector3f &position)
+void rl::Object::transform(const Matrix &rotation)
 {
-	::Vector3 p = { position[0], position[1], position[2] };
-	m_rlModel.position = Vector3Add(m_rlModel.position, p);
+	m_transform = rotation;
 }
 
-void rl::Object::forceStop()
+void rl::Object::reset(const Vector3 &position, const rl::Quaternion &rotation)
 {
-	m_rlModel.position.y = 0.0f;
-	m_feedbackTau = Vector6f::Zero();
 	m_tau = Vector6f::Zero();
+	bodyStore([&](auto &store) { store.reset(m_body, position, rotation); });
+}
+
+void rl::Object::decayTorque(const rl::ControlStep &step)
+{
+	for (int i = 0; i < m_tau.size(); ++i) {
+		auto &t = m_tau[i];
+		if (std::abs(t) < 0.01f) t = 0;
+		else if (i < 3) {
+			t *= step.thrustDecay;
+			t = std::clamp(t, m_rlModel.thrust.x, m_rlModel.thrust.y);
+		} else {
+			t *= step.momentDecay;
+			t = std::clamp(t, m_rlModel.moment.x, m_rlModel.moment.y);
+		}
+	}
 }
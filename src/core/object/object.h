@@ -5,10 +5,12 @@
 #include <raylib.h>
 #include <raymath.h>
 
+#include "body.h"
+#include "input.h"
 #include "loader.h"
+#include "pool.h"
 #include "quaternion.h"
-
-using Matrix6f = Eigen::Matrix<float, 6, 6>;
+#include "shape.h"
 
 namespace rl
 {
@@ -17,11 +19,12 @@ namespace rl
  * @brief Creates a rotation matrix around the X-axis.
  *
  * @param angle Angle in radians to rotate around the X-axis.
- * @return Matrix3f Rotation matrix for the X-axis rotation.
+ * @return Mat3<S> Rotation matrix for the X-axis rotation.
  */
-inline Matrix3f Rx(float angle)
+template <typename S>
+inline Mat3<S> Rx(S angle)
 {
-	return Matrix3f{
+	return Mat3<S>{
 		{1, 0, 0},
 		{0, std::cos(angle), -std::sin(angle)},
 		{0, std::sin(angle), std::cos(angle)}
@@ -32,11 +35,12 @@ inline Matrix3f Rx(float angle)
  * @brief Creates a rotation matrix around the Y-axis.
  *
  * @param angle Angle in radians to rotate around the Y-axis.
- * @return Matrix3f Rotation matrix for the Y-axis rotation.
+ * @return Mat3<S> Rotation matrix for the Y-axis rotation.
  */
-inline Matrix3f Ry(float angle)
+template <typename S>
+inline Mat3<S> Ry(S angle)
 {
-	return Matrix3f{
+	return Mat3<S>{
 		{std::cos(angle), 0, std::sin(angle)},
 		{0, 1, 0},
 		{-std::sin(angle), 0, std::cos(angle)}
@@ -47,30 +51,71 @@ inline Matrix3f Ry(float angle)
  * @brief Creates a rotation matrix around the Z-axis.
  *
  * @param angle Angle in radians to rotate around the Z-axis.
- * @return Matrix3f Rotation matrix for the Z-axis rotation.
+ * @return Mat3<S> Rotation matrix for the Z-axis rotation.
  */
-inline Matrix3f Rz(float angle)
+template <typename S>
+inline Mat3<S> Rz(S angle)
 {
-	return Matrix3f{
+	return Mat3<S>{
 		{std::cos(angle), -std::sin(angle), 0},
 		{std::sin(angle), std::cos(angle), 0},
 		{0, 0, 1}
 	};
 }
 
+// Rate in Hz the controllers and the body response were tuned at, the frame rate the objects were updated at
+// before the physics got its own fixed rate. See rl::Object::getTorque and rl::BasicBodyStore::setResponseTime.
+inline constexpr float CONTROL_RATE = 60.0f;
+
+/**
+ * @struct ControlStep
+ * @brief Scaling of the controller ramps and decays, tuned per rl::CONTROL_RATE period, to the length of a step.
+ * It only depends on the step time, the application computes it once per step for all the objects.
+ */
+struct ControlStep
+{
+	/**
+	 * @brief Computes the scaling for the step.
+	 *
+	 * @param dt Time step in seconds.
+	 */
+	static ControlStep at(float dt);
+
+	// Number of rl::CONTROL_RATE periods in the step, the ramps are multiplied by it.
+	float periods = 0.0f;
+	// Factors the thrust and the moment torques decay by during the step.
+	float thrustDecay = 1.0f;
+	float momentDecay = 1.0f;
+};
+
+class Object;
+
+/**
+ * @class ObjectDeleter
+ * @brief Destroys an object through the allocator it was created with, see rl::makeObject.
+ * Objects without a destroy function were allocated with new.
+ */
+struct ObjectDeleter
+{
+	void (*destroy)(Object *) = nullptr;
+
+	void operator()(Object *object) const;
+};
+
 /**
  * @class Object
  * @brief Base class for 3D objects in the simulation.
  *
  * This class represents a 3D object with a model, physics properties, and methods for
  * loading, updating, and rendering the object. The object physics are based on rigid body dynamics,
- * and it provides methods to calculate torques and kinematics. The rotations are handled using quaternions,
- * and the object can be transformed and moved in 3D space.
+ * the rigid body state itself lives in the rl::BodyStore and the object holds a handle to it.
+ * The object provides the torques driving the body. The rotations are handled using quaternions.
  */
 class Object
 {
 public:
-	using Ptr = std::shared_ptr<Object>;
+	// Sole owner of the object, moving it never touches a reference count.
+	using Ptr = std::unique_ptr<Object, ObjectDeleter>;
 
 	/**
 	 * @brief Constructs an Object with the specified model.
@@ -78,91 +123,168 @@ public:
 	 * @param model The model to be used for the object.
 	 */
 	Object(const rl::Model &model);
+	Object(const Object &) = delete;
+	Object &operator=(const Object &) = delete;
 	virtual ~Object();
 
 	/**
 	 * @brief Loads the model for the object.
+	 * An oriented box fitted to the loaded meshes becomes the collision shape of the object body.
 	 */
 	void loadModel();
 	/**
-	 * @brief Updates the object state based on the elapsed time.
+	 * @brief Applies a reloaded configuration to the live object.
+	 * The pose of the object is kept, the input parameters, mass and inertia are replaced. The model is loaded again
+	 * only if its files or its scale changed.
+	 *
+	 * @param model The reloaded model configuration.
+	 */
+	void reconfigure(const rl::Model &model);
+	/**
+	 * @brief Returns true once the model of the object is loaded, until then a placeholder is drawn.
+	 */
+	bool loaded() const;
+	/**
+	 * @brief Updates the torque applied to the object body.
+	 * The body itself is integrated in batch with all the other bodies by rl::BodyStore::integrate.
+	 *
+	 * @param input Input snapshot of the current step.
+	 * @param step Controller scaling of the current step.
+	 */
+	void update(const rl::InputState &input, const rl::ControlStep &step);
+	/**
+	 * @brief Sets the torque applied to the object body during the next integration.
+	 * The update pass of rl::TypedLane sets the torques in the store of its precision directly instead.
+	 *
+	 * @param tau The torque vector applied to the object.
+	 */
+	void applyTorque(const Vector6f &tau);
+	/**
+	 * @brief Computes the render state between the previous and the current physics state.
+	 * The rotation matrix of the render rotation is set afterwards by transform().
+	 *
+	 * @param alpha Interpolation factor in range [0, 1], 0 being the previous and 1 the current state.
+	 */
+	void interpolate(float alpha);
+	/**
+	 * @brief Sets the rotation matrix the object model is drawn with.
+	 * The application converts the render rotations of all the objects at once, see rl::quatbatch::toMatrices.
 	 *
-	 * @param dt Elapsed time since the last update in seconds.
+	 * @param rotation Rotation matrix of the render rotation.
 	 */
-	void update(float dt);
+	void transform(const Matrix &rotation);
 
 	/**
 	 * @brief Virtual method to get the torque applied to the object.
+	 * Called concurrently for different objects, the implementation may only touch the object itself.
+	 * Final types registered by rl::ObjectFactory::add<T> are updated by a rl::TypedLane, which calls it without
+	 * the virtual dispatch. The controllers ramp and decay their torques per rl::CONTROL_RATE period, scaled by
+	 * the step, so they respond the same at any physics rate.
 	 *
+	 * @param input Input snapshot of the current step.
+	 * @param step Controller scaling of the current step.
 	 * @return Vector6f The torque vector applied to the object.
 	 */
-	virtual Vector6f getTorque() = 0;
+	virtual Vector6f getTorque(const rl::InputState &input, const rl::ControlStep &step) = 0;
 
+	/**
+	 * @brief Returns the current position of the object.
+	 */
+	Vector3 position() const;
 	/**
 	 * @brief Returns the current rotation of the object represented as a quaternion.
 	 */
 	rl::Quaternion rotation() const;
+	/**
+	 * @brief Returns the interpolated position the object is rendered at.
+	 */
+	Vector3 renderPosition() const;
+	/**
+	 * @brief Returns the interpolated rotation the object is rendered with.
+	 */
+	rl::Quaternion renderRotation() const;
 	/**
 	 * @brief Draws the object in the 3D space.
 	 */
 	void draw() const;
 
 	/**
-	 * @brief Returns the internal model representation of the object.
+	 * @brief Returns the handle of the object body in the rl::BasicBodyStore of its precision.
 	 */
-	rl::Model rlModel() const;
+	rl::BodyStore::Handle body() const;
 	/**
-	 * @brief Returns the raylib model associated with this object.
+	 * @brief Returns the precision the object body is stored and integrated in.
 	 */
-	std::shared_ptr<::Model> model() const;
+	rl::Precision precision() const;
 
-protected:
 	/**
-	 * @brief Calculates the rigid body for the object.
-	 *
-	 * @param tau The torque vector applied to the object.
-	 * @param dt Elapsed time since the last update in seconds.
-	 * @return Vector6f The updated rigid body state after applying the torque.
+	 * @brief Returns the internal model representation of the object.
 	 */
-	Vector6f rigidBody(Vector6f &tau, float dt);
+	const rl::Model &rlModel() const;
 	/**
-	 * @brief Calculates the kinematics of the object based on the input control vector and time step.
-	 *
-	 * @param nu The control vector containing the input forces and torques.
-	 * @param dt The time step for the kinematics calculation.
+	 * @brief Returns the raylib model associated with this object, shared with the other objects using it.
 	 */
-	std::pair<Eigen::Vector3f, rl::Quaternion> kinematics(const Vector6f &nu, float dt);
+	std::shared_ptr<const ::Model> model() const;
 
+protected:
 	/**
-	 * @brief Transforms the object using the specified quaternion.
+	 * @brief Sets the rotation the object model is drawn with.
 	 *
 	 * @param quat The quaternion representing the rotation to be applied to the object.
 	 */
 	void transform(const rl::Quaternion &quat);
 	/**
-	 * @brief Moves the object to the specified position in 3D space.
+	 * @brief Moves the object body to the specified pose and clears its velocity.
 	 *
-	 * @param position The new position to move the object to.
+	 * @param position The new position of the object.
+	 * @param rotation The new rotation of the object.
 	 */
-	void move(const Eigen::Vector3f &position);
-
+	void reset(const Vector3 &position, const rl::Quaternion &rotation);
+	/**
+	 * @brief Decays the torque over the step and clamps it to the thrust and moment limits of the model.
+	 * The components close to zero are cleared.
+	 *
+	 * @param step Controller scaling of the current step.
+	 */
+	void decayTorque(const rl::ControlStep &step);
 
-	/* TODO:
-	 * 1. Add collision check of the model and another object
-	 **/
+private:
 	/**
-	 * @brief Forces the object to stop immediately and reset its state.
+	 * @brief Calls the function with the body store of the object precision.
 	 */
-	virtual void forceStop();
+	template <typename Function>
+	decltype(auto) bodyStore(Function &&function) const
+	{
+		return rl::withBodyStore(m_precision, std::forward<Function>(function));
+	}
 
 protected:
 	rl::Model m_rlModel;
-	std::shared_ptr<::Model> m_model;
-	Matrix6f m_invMrb;
-	Matrix3f m_inertiaMatrix;
-	Vector6f m_feedbackTau;
+	std::shared_ptr<const ::Model> m_model;
+	// Transform of this instance, the shared model itself is never modified.
+	Matrix m_transform;
+	rl::BodyStore::Handle m_body;
 	Vector6f m_tau;
-	rl::Quaternion m_quat;
+
+	// Interpolated state that is rendered.
+	Vector3 m_renderPosition;
+	rl::Quaternion m_renderQuat;
+
+private:
+	rl::Precision m_precision;
 };
 
+/**
+ * @brief Creates the object of the type T in its rl::Pool, the slot is given back when the pointer is destroyed.
+ *
+ * @param args Arguments of the constructor of T.
+ * @return rl::Object::Ptr Owning pointer of the created object.
+ */
+template <typename T, typename... Args>
+Object::Ptr makeObject(Args &&...args)
+{
+	return Object::Ptr(Pool<T>::instance().create(std::forward<Args>(args)...),
+		ObjectDeleter{ [](Object *object) { Pool<T>::instance().destroy(static_cast<T *>(object)); } });
+}
+
 }
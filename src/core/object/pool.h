@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace rl
+{
+
+/**
+ * @class PoolHandle
+ * @brief Generational handle of an object in a rl::Pool.
+ * The slot of a destroyed object is reused, the generation tells the handles of its previous objects apart,
+ * so a stale handle resolves to nullptr instead of to the new object.
+ */
+struct PoolHandle
+{
+	static constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+	uint32_t index = INVALID;
+	uint32_t generation = 0;
+
+	bool operator==(const PoolHandle &) const = default;
+};
+
+/**
+ * @class Pool
+ * @brief Singleton pool allocator of the objects of the type T.
+ *
+ * The objects live in slots aligned for T, allocated in chunks of CHUNK_SIZE slots. The chunks never move, so the
+ * objects keep their address, and freed slots are reused before a new chunk is allocated, so spawning and despawning
+ * objects takes constant time and does not fragment the heap. The pool is not synchronized, the objects are created
+ * and destroyed by the main thread.
+ */
+template <typename T>
+class Pool
+{
+public:
+	static constexpr size_t CHUNK_SIZE = 256;
+
+	/**
+	 * @brief Returns the singleton instance of the pool of T.
+	 *
+	 * @return Pool& Reference to the singleton instance.
+	 */
+	static Pool &instance()
+	{
+		static Pool instance;
+		return instance;
+	}
+
+	/**
+	 * @brief Constructs an object in a free slot, a new chunk is allocated only if all the slots are taken.
+	 *
+	 * @param args Arguments of the constructor of T.
+	 * @return T* The constructed object, owned by the pool until it is destroyed.
+	 */
+	template <typename... Args>
+	T *create(Args &&...args);
+	/**
+	 * @brief Destroys the object and frees its slot, the handles of the object become stale.
+	 *
+	 * @param object Object created by this pool.
+	 */
+	void destroy(T *object);
+
+	/**
+	 * @brief Returns the handle of the live object.
+	 */
+	PoolHandle handle(const T *object) const;
+	/**
+	 * @brief Returns the object of the handle, nullptr if it was destroyed.
+	 */
+	T *get(PoolHandle handle) const;
+
+	/**
+	 * @brief Allocates the chunks for the number of objects, so creating them in bulk does not allocate.
+	 *
+	 * @param count Total number of objects the pool is expected to hold.
+	 */
+	void reserve(size_t count);
+	/**
+	 * @brief Returns the number of live objects.
+	 */
+	size_t size() const;
+	/**
+	 * @brief Returns the number of slots in the allocated chunks.
+	 */
+	size_t capacity() const;
+
+private:
+	Pool() = default;
+	Pool(const Pool &) = delete;
+	Pool &operator=(const Pool &) = delete;
+
+	/**
+	 * @brief Slot of a single object, the storage comes first so the object address is the slot address.
+	 */
+	struct Slot
+	{
+		alignas(T) std::byte storage[sizeof(T)];
+		uint32_t index;
+		uint32_t generation = 0;
+		uint32_t nextFree = PoolHandle::INVALID;
+		bool alive = false;
+	};
+
+	Slot &slot(uint32_t index) const { return m_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE]; }
+	static Slot *slotOf(const T *object) { return reinterpret_cast<Slot *>(const_cast<T *>(object)); }
+	/**
+	 * @brief Allocates a chunk and links its slots into the free list.
+	 */
+	void grow();
+
+private:
+	std::vector<std::unique_ptr<Slot[]>> m_chunks;
+	uint32_t m_freeHead = PoolHandle::INVALID;
+	size_t m_size = 0;
+};
+
+template <typename T>
+template <typename... Args>
+T *Pool<T>::create(Args &&...args)
+{
+	if (m_freeHead == PoolHandle::INVALID) {
+		grow();
+	}
+
+	Slot &free = slot(m_freeHead);
+	T *object = ::new (free.storage) T(std::forward<Args>(args)...);
+	m_freeHead = free.nextFree;
+	free.alive = true;
+	++m_size;
+	return std::launder(object);
+}
+
+template <typename T>
+void Pool<T>::destroy(T *object)
+{
+	Slot *freed = slotOf(object);
+	std::destroy_at(object);
+	freed->alive = false;
+	++freed->generation;
+	freed->nextFree = m_freeHead;
+	m_freeHead = freed->index;
+	--m_size;
+}
+
+template <typename T>
+PoolHandle Pool<T>::handle(const T *object) const
+{
+	const Slot *owner = slotOf(object);
+	return PoolHandle{ owner->index, owner->generation };
+}
+
+template <typename T>
+T *Pool<T>::get(PoolHandle handle) const
+{
+	if (handle.index >= capacity()) {
+		return nullptr;
+	}
+	Slot &owner = slot(handle.index);
+	if (!owner.alive || owner.generation != handle.generation) {
+		return nullptr;
+	}
+	return std::launder(reinterpret_cast<T *>(owner.storage));
+}
+
+template <typename T>
+void Pool<T>::reserve(size_t count)
+{
+	while (capacity() < count) {
+		grow();
+	}
+}
+
+template <typename T>
+size_t Pool<T>::size() const
+{
+	return m_size;
+}
+
+template <typename T>
+size_t Pool<T>::capacity() const
+{
+	return m_chunks.size() * CHUNK_SIZE;
+}
+
+template <typename T>
+void Pool<T>::grow()
+{
+	uint32_t first = capacity();
+	m_chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+
+	// Linked in reverse, so the slots are handed out in the order of their addresses.
+	Slot *chunk = m_chunks.back().get();
+	for (size_t i = CHUNK_SIZE; i-- > 0;) {
+		chunk[i].index = first + i;
+		chunk[i].nextFree = m_freeHead;
+		m_freeHead = first + i;
+	}
+}
+
+}
@@ -0,0 +1,327 @@
+#include "batch.h"
+
+#include <array>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RL_QUATBATCH_AVX2 1
+#endif
+
+using rl::quatbatch::ConstQuaternions;
+using rl::quatbatch::ConstVectors;
+using rl::quatbatch::Quaternions;
+using rl::quatbatch::Vectors;
+
+namespace
+{
+
+// Matrix M of the product q * v * q', row major. For a unit quaternion it is the rotation matrix.
+using Matrix3x3 = std::array<float, 9>;
+
+Matrix3x3 sandwich(const rl::Quaternion &q)
+{
+	float x = q.x(), y = q.y(), z = q.z(), w = q.w();
+	float s = w * w - (x * x + y * y + z * z);
+
+	// M = s * I + 2 * u * u' + 2 * w * [u]x, with u the vector part of the quaternion.
+	return {
+		s + 2.0f * x * x, 2.0f * (x * y - w * z), 2.0f * (x * z + w * y),
+		2.0f * (x * y + w * z), s + 2.0f * y * y, 2.0f * (y * z - w * x),
+		2.0f * (x * z - w * y), 2.0f * (y * z + w * x), s + 2.0f * z * z,
+	};
+}
+
+/*
+ * Scalar kernels, they process the elements in range [begin, end). They are used on CPUs without AVX2 and for
+ * the elements left over after the last full AVX2 register.
+ */
+
+void multiplyScalar(ConstQuaternions a, ConstQuaternions b, Quaternions out, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
+		float ax = a.x[i], ay = a.y[i], az = a.z[i], aw = a.w[i];
+		float bx = b.x[i], by = b.y[i], bz = b.z[i], bw = b.w[i];
+		out.x[i] = ax * bw + aw * bx + ay * bz - az * by;
+		out.y[i] = ay * bw + aw * by + az * bx - ax * bz;
+		out.z[i] = az * bw + aw * bz + ax * by - ay * bx;
+		out.w[i] = aw * bw - ax * bx - ay * by - az * bz;
+	}
+}
+
+void normalizeScalar(Quaternions q, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
+		float mag = std::sqrt(q.x[i] * q.x[i] + q.y[i] * q.y[i] + q.z[i] * q.z[i] + q.w[i] * q.w[i]);
+		float inv = 1.0f / (mag == 0.0f ? 1.0f : mag);
+		q.x[i] *= inv;
+		q.y[i] *= inv;
+		q.z[i] *= inv;
+		q.w[i] *= inv;
+	}
+}
+
+void rotateScalar(ConstQuaternions q, ConstVectors v, Vectors out, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
+		float x = q.x[i], y = q.y[i], z = q.z[i], w = q.w[i];
+		float vx = v.x[i], vy = v.y[i], vz = v.z[i];
+
+		// q * v * q' = (w^2 - |u|^2) * v + 2 * (u . v) * u + 2 * w * (u x v)
+		float s = w * w - (x * x + y * y + z * z);
+		float d = 2.0f * (x * vx + y * vy + z * vz);
+		float c = 2.0f * w;
+		out.x[i] = s * vx + d * x + c * (y * vz - z * vy);
+		out.y[i] = s * vy + d * y + c * (z * vx - x * vz);
+		out.z[i] = s * vz + d * z + c * (x * vy - y * vx);
+	}
+}
+
+void rotateScalar(const Matrix3x3 &m, ConstVectors v, Vectors out, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
+		float vx = v.x[i], vy = v.y[i], vz = v.z[i];
+		out.x[i] = m[0] * vx + m[1] * vy + m[2] * vz;
+		out.y[i] = m[3] * vx + m[4] * vy + m[5] * vz;
+		out.z[i] = m[6] * vx + m[7] * vy + m[8] * vz;
+	}
+}
+
+void toMatricesScalar(ConstQuaternions q, ::Matrix *out, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
+		out[i] = rl::Quaternion(q.x[i], q.y[i], q.z[i], q.w[i]).toRlRotMatrix();
+	}
+}
+
+#if defined(RL_QUATBATCH_AVX2)
+
+/*
+ * AVX2 kernels, they process eight elements at once and return the number of elements processed, which is the
+ * count rounded down to a multiple of eight. They are compiled for AVX2 regardless of the build flags and only
+ * called once the CPU is known to support it.
+ */
+
+#define RL_AVX2 __attribute__((target("avx2,fma")))
+
+RL_AVX2 size_t multiplyAvx2(ConstQuaternions a, ConstQuaternions b, Quaternions out, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 ax = _mm256_loadu_ps(a.x + i), ay = _mm256_loadu_ps(a.y + i);
+		__m256 az = _mm256_loadu_ps(a.z + i), aw = _mm256_loadu_ps(a.w + i);
+		__m256 bx = _mm256_loadu_ps(b.x + i), by = _mm256_loadu_ps(b.y + i);
+		__m256 bz = _mm256_loadu_ps(b.z + i), bw = _mm256_loadu_ps(b.w + i);
+
+		__m256 x = _mm256_fmadd_ps(ax, bw, _mm256_fmadd_ps(aw, bx, _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by))));
+		__m256 y = _mm256_fmadd_ps(ay, bw, _mm256_fmadd_ps(aw, by, _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz))));
+		__m256 z = _mm256_fmadd_ps(az, bw, _mm256_fmadd_ps(aw, bz, _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx))));
+		__m256 w = _mm256_fnmadd_ps(ax, bx, _mm256_fnmadd_ps(ay, by, _mm256_fmsub_ps(aw, bw, _mm256_mul_ps(az, bz))));
+
+		_mm256_storeu_ps(out.x + i, x);
+		_mm256_storeu_ps(out.y + i, y);
+		_mm256_storeu_ps(out.z + i, z);
+		_mm256_storeu_ps(out.w + i, w);
+	}
+	return i;
+}
+
+RL_AVX2 size_t normalizeAvx2(Quaternions q, size_t count)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(q.x + i), y = _mm256_loadu_ps(q.y + i);
+		__m256 z = _mm256_loadu_ps(q.z + i), w = _mm256_loadu_ps(q.w + i);
+
+		__m256 mag = _mm256_sqrt_ps(
+			_mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_fmadd_ps(z, z, _mm256_mul_ps(w, w)))));
+		// The division is exact unlike the reciprocal estimate, zero quaternions are divided by one.
+		__m256 inv = _mm256_div_ps(one, _mm256_blendv_ps(mag, one, _mm256_cmp_ps(mag, zero, _CMP_EQ_OQ)));
+
+		_mm256_storeu_ps(q.x + i, _mm256_mul_ps(x, inv));
+		_mm256_storeu_ps(q.y + i, _mm256_mul_ps(y, inv));
+		_mm256_storeu_ps(q.z + i, _mm256_mul_ps(z, inv));
+		_mm256_storeu_ps(q.w + i, _mm256_mul_ps(w, inv));
+	}
+	return i;
+}
+
+RL_AVX2 size_t rotateAvx2(ConstQuaternions q, ConstVectors v, Vectors out, size_t count)
+{
+	const __m256 two = _mm256_set1_ps(2.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(q.x + i), y = _mm256_loadu_ps(q.y + i);
+		__m256 z = _mm256_loadu_ps(q.z + i), w = _mm256_loadu_ps(q.w + i);
+		__m256 vx = _mm256_loadu_ps(v.x + i), vy = _mm256_loadu_ps(v.y + i), vz = _mm256_loadu_ps(v.z + i);
+
+		__m256 s = _mm256_fnmadd_ps(x, x, _mm256_fnmadd_ps(y, y, _mm256_fmsub_ps(w, w, _mm256_mul_ps(z, z))));
+		__m256 d = _mm256_mul_ps(two, _mm256_fmadd_ps(x, vx, _mm256_fmadd_ps(y, vy, _mm256_mul_ps(z, vz))));
+		__m256 c = _mm256_mul_ps(two, w);
+
+		__m256 cx = _mm256_fmsub_ps(y, vz, _mm256_mul_ps(z, vy));
+		__m256 cy = _mm256_fmsub_ps(z, vx, _mm256_mul_ps(x, vz));
+		__m256 cz = _mm256_fmsub_ps(x, vy, _mm256_mul_ps(y, vx));
+
+		_mm256_storeu_ps(out.x + i, _mm256_fmadd_ps(s, vx, _mm256_fmadd_ps(d, x, _mm256_mul_ps(c, cx))));
+		_mm256_storeu_ps(out.y + i, _mm256_fmadd_ps(s, vy, _mm256_fmadd_ps(d, y, _mm256_mul_ps(c, cy))));
+		_mm256_storeu_ps(out.z + i, _mm256_fmadd_ps(s, vz, _mm256_fmadd_ps(d, z, _mm256_mul_ps(c, cz))));
+	}
+	return i;
+}
+
+RL_AVX2 size_t rotateAvx2(const Matrix3x3 &m, ConstVectors v, Vectors out, size_t count)
+{
+	// Plain arrays, std::array drops the alignment attribute of the vector type (-Wignored-attributes).
+	__m256 r[9];
+	for (size_t k = 0; k < std::size(r); ++k) {
+		r[k] = _mm256_set1_ps(m[k]);
+	}
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 vx = _mm256_loadu_ps(v.x + i), vy = _mm256_loadu_ps(v.y + i), vz = _mm256_loadu_ps(v.z + i);
+		_mm256_storeu_ps(out.x + i, _mm256_fmadd_ps(r[0], vx, _mm256_fmadd_ps(r[1], vy, _mm256_mul_ps(r[2], vz))));
+		_mm256_storeu_ps(out.y + i, _mm256_fmadd_ps(r[3], vx, _mm256_fmadd_ps(r[4], vy, _mm256_mul_ps(r[5], vz))));
+		_mm256_storeu_ps(out.z + i, _mm256_fmadd_ps(r[6], vx, _mm256_fmadd_ps(r[7], vy, _mm256_mul_ps(r[8], vz))));
+	}
+	return i;
+}
+
+/**
+ * @brief Transposes eight registers of eight floats, lane k of register j ends up in lane j of register k.
+ */
+RL_AVX2 void transpose(__m256 (&r)[8])
+{
+	__m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+	__m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+	__m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+	__m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+	r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+RL_AVX2 size_t toMatricesAvx2(ConstQuaternions q, ::Matrix *out, size_t count)
+{
+	static_assert(sizeof(::Matrix) == 16 * sizeof(float));
+
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(q.x + i), y = _mm256_loadu_ps(q.y + i);
+		__m256 z = _mm256_loadu_ps(q.z + i), w = _mm256_loadu_ps(q.w + i);
+
+		__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+		__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+		__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+		// The matrices are stored row after row, a row is three entries of the rotation and a zero.
+		__m256 upper[8] = {
+			_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), _mm256_mul_ps(two, _mm256_sub_ps(xy, wz)),
+			_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), zero,
+			_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), _mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one),
+			_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), zero,
+		};
+		__m256 lower[8] = {
+			_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), _mm256_mul_ps(two, _mm256_add_ps(yz, wx)),
+			_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), zero,
+			zero, zero, zero, one,
+		};
+
+		// Registers hold one entry of eight matrices, transposed they hold eight entries of one matrix.
+		transpose(upper);
+		transpose(lower);
+		for (size_t k = 0; k < 8; ++k) {
+			float *matrix = reinterpret_cast<float *>(out + i + k);
+			_mm256_storeu_ps(matrix, upper[k]);
+			_mm256_storeu_ps(matrix + 8, lower[k]);
+		}
+	}
+	return i;
+}
+
+#undef RL_AVX2
+
+#endif
+
+}
+
+bool rl::quatbatch::avx2()
+{
+#if defined(RL_QUATBATCH_AVX2)
+	static const bool supported = []() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	}();
+	return supported;
+#else
+	return false;
+#endif
+}
+
+void rl::quatbatch::multiply(ConstQuaternions lhs, ConstQuaternions rhs, Quaternions out, size_t count)
+{
+	size_t done = 0;
+#if defined(RL_QUATBATCH_AVX2)
+	if (avx2()) done = multiplyAvx2(lhs, rhs, out, count);
+#endif
+	multiplyScalar(lhs, rhs, out, done, count);
+}
+
+void rl::quatbatch::normalize(Quaternions q, size_t count)
+{
+	size_t done = 0;
+#if defined(RL_QUATBATCH_AVX2)
+	if (avx2()) done = normalizeAvx2(q, count);
+#endif
+	normalizeScalar(q, done, count);
+}
+
+void rl::quatbatch::rotate(ConstQuaternions q, ConstVectors v, Vectors out, size_t count)
+{
+	size_t done = 0;
+#if defined(RL_QUATBATCH_AVX2)
+	if (avx2()) done = rotateAvx2(q, v, out, count);
+#endif
+	rotateScalar(q, v, out, done, count);
+}
+
+void rl::quatbatch::rotate(const rl::Quaternion &q, ConstVectors v, Vectors out, size_t count)
+{
+	// The same rotation for all the vectors, it is applied as a matrix.
+	Matrix3x3 m = sandwich(q);
+
+	size_t done = 0;
+#if defined(RL_QUATBATCH_AVX2)
+	if (avx2()) done = rotateAvx2(m, v, out, count);
+#endif
+	rotateScalar(m, v, out, done, count);
+}
+
+void rl::quatbatch::toMatrices(ConstQuaternions q, ::Matrix *out, size_t count)
+{
+	size_t done = 0;
+#if defined(RL_QUATBATCH_AVX2)
+	if (avx2()) done = toMatricesAvx2(q, out, count);
+#endif
+	toMatricesScalar(q, out, done, count);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+#include <raylib.h>
+
+#include "quaternion.h"
+
+namespace rl::quatbatch
+{
+
+/**
+ * @class QuaternionSpan
+ * @brief Structure-of-arrays view of quaternions, every component is a separate contiguous array.
+ * The arrays are not owned, the rotations of rl::BodyStore are stored in this layout.
+ */
+template <typename T>
+struct QuaternionSpan
+{
+	T *x;
+	T *y;
+	T *z;
+	T *w;
+
+	operator QuaternionSpan<const T>() const
+		requires(!std::is_const_v<T>)
+	{
+		return { x, y, z, w };
+	}
+};
+
+/**
+ * @class VectorSpan
+ * @brief Structure-of-arrays view of 3D vectors, every component is a separate contiguous array.
+ */
+template <typename T>
+struct VectorSpan
+{
+	T *x;
+	T *y;
+	T *z;
+
+	operator VectorSpan<const T>() const
+		requires(!std::is_const_v<T>)
+	{
+		return { x, y, z };
+	}
+};
+
+using Quaternions = QuaternionSpan<float>;
+using ConstQuaternions = QuaternionSpan<const float>;
+using Vectors = VectorSpan<float>;
+using ConstVectors = VectorSpan<const float>;
+
+/**
+ * @brief Returns true if the kernels run the AVX2 code path on this CPU, otherwise the scalar one is used.
+ */
+bool avx2();
+
+/**
+ * @brief Hamilton products out[i] = lhs[i] * rhs[i].
+ * The output may be the same arrays as one of the inputs.
+ *
+ * @param lhs Left operands.
+ * @param rhs Right operands.
+ * @param out Products.
+ * @param count Number of quaternions.
+ */
+void multiply(ConstQuaternions lhs, ConstQuaternions rhs, Quaternions out, size_t count);
+
+/**
+ * @brief Normalizes the quaternions in place, zero quaternions are kept as they are.
+ *
+ * @param q Quaternions to be normalized.
+ * @param count Number of quaternions.
+ */
+void normalize(Quaternions q, size_t count);
+
+/**
+ * @brief Rotates every vector by its quaternion, out[i] = q[i] * v[i] * q[i]'.
+ * The output may be the same arrays as the input vectors.
+ *
+ * @param q Rotations, unit quaternions rotate without scaling.
+ * @param v Vectors to be rotated.
+ * @param out Rotated vectors.
+ * @param count Number of vectors.
+ */
+void rotate(ConstQuaternions q, ConstVectors v, Vectors out, size_t count);
+/**
+ * @brief Rotates all the vectors by the same quaternion, out[i] = q * v[i] * q'.
+ * The output may be the same arrays as the input vectors.
+ *
+ * @param q Rotation, a unit quaternion rotates without scaling.
+ * @param v Vectors to be rotated.
+ * @param out Rotated vectors.
+ * @param count Number of vectors.
+ */
+void rotate(const rl::Quaternion &q, ConstVectors v, Vectors out, size_t count);
+
+/**
+ * @brief Converts the unit quaternions to raylib rotation matrices, as rl::Quaternion::toRlRotMatrix does.
+ *
+ * @param q Rotations.
+ * @param out Array of count matrices.
+ * @param count Number of quaternions.
+ */
+void toMatrices(ConstQuaternions q, ::Matrix *out, size_t count);
+
+}
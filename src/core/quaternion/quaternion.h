@@ -1,12 +1,31 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
 #include <print>
+#include <type_traits>
 
 #include <raylib.h>
 #include <raymath.h>
 #include <Eigen/Dense>
 
-using Vector6f = Eigen::Matrix<float, 6, 1>;
+namespace rl
+{
+
+// Fixed size Eigen types of the rigid body math, templated on the scalar.
+template <typename S> using Vec3 = Eigen::Matrix<S, 3, 1>;
+template <typename S> using Vec4 = Eigen::Matrix<S, 4, 1>;
+template <typename S> using Vec6 = Eigen::Matrix<S, 6, 1>;
+template <typename S> using Mat3 = Eigen::Matrix<S, 3, 3>;
+template <typename S> using Mat4 = Eigen::Matrix<S, 4, 4>;
+template <typename S> using Mat6 = Eigen::Matrix<S, 6, 6>;
+
+}
+
+using Vector6f = rl::Vec6<float>;
+using Vector6d = rl::Vec6<double>;
 using Eigen::Vector3f;
 using Eigen::Vector4f;
 using Eigen::Matrix3f;
@@ -15,94 +34,620 @@ using Eigen::Matrix4f;
 namespace rl
 {
 
-Matrix3f skewMarix(const Vector3f &v);
+/**
+ * @brief Scalar type the rigid body state of an object is stored and integrated in.
+ */
+enum class Precision
+{
+	Float,
+	Double,
+};
 
 /**
- * @class Quaternion
+ * @class ScalarTraits
+ * @brief Operations that differ between the floating point scalars and the SIMD packs, see simd.h for the packs.
+ */
+template <typename S>
+struct ScalarTraits
+{
+	/**
+	 * @brief Returns lhs where the condition holds and rhs elsewhere.
+	 */
+	static S select(bool condition, S lhs, S rhs) { return condition ? lhs : rhs; }
+	/**
+	 * @brief Returns true if the condition holds in any lane.
+	 */
+	static bool any(bool condition) { return condition; }
+};
+
+template <typename S>
+Mat3<S> skewMarix(const Vec3<S> &v);
+
+/**
+ * @class BasicQuaternion
  * @brief Represents a quaternion for 3D rotations and transformations.
  *
+ * The scalar is float, double or one of the SIMD packs of simd.h, which hold one quaternion per lane. The packs
+ * support the arithmetic, the rotations, the integration and the normalization. Members that branch on the value
+ * (slerp, the conversions from matrices and to euler angles) need a floating point scalar. rl::Quaternion is the
+ * float instantiation, the fixed layouts of the body store are processed by the kernels of batch.h. The raylib
+ * conversions are the render boundary, they always produce float values.
  */
-class Quaternion
+template <typename S>
+class BasicQuaternion
 {
-	friend Quaternion operator+(const Quaternion &lhs, const Quaternion &rhs);
-	friend Quaternion operator-(const Quaternion &lhs, const Quaternion &rhs);
-	friend Quaternion operator*(const Quaternion &lhs, const Quaternion &rhs);
-	friend Quaternion operator*(const Quaternion &lhs, double rhs);
-	friend Quaternion operator*(double lhs, const Quaternion &rhs);
-	friend Quaternion operator/(const Quaternion &lhs, const Quaternion &rhs);
-	friend float operator&(const Quaternion &lhs, const Quaternion &rhs);
-
 public:
-	Quaternion(float x, float y, float z, float w);
-	explicit Quaternion(::Quaternion quat)
-		: m_data{ quat.x, quat.y, quat.z, quat.w }
-	{
-	};
+	using Scalar = S;
+
+	BasicQuaternion(S x, S y, S z, S w);
+	explicit BasicQuaternion(const Vec4<S> &data);
+	explicit BasicQuaternion(::Quaternion quat);
+
+	S x() const { return m_data.x(); }
+	S y() const { return m_data.y(); }
+	S z() const { return m_data.z(); }
+	S w() const { return m_data.w(); }
 
-	float x() const { return m_data.x(); }
-	float y() const { return m_data.y(); }
-	float z() const { return m_data.z(); }
-	float w() const { return m_data.w(); }
+	/**
+	 * @brief Converts the quaternion to another scalar type, e.g. a double precision state to float for rendering.
+	 */
+	template <typename T>
+	BasicQuaternion<T> cast() const;
 
-	static rl::Quaternion fromEuler(float x, float y, float z);
-	static rl::Quaternion fromEuler(const Vector3f &euler);
-	static rl::Quaternion fromEuler(const Vector3 &euler);
+	static BasicQuaternion fromEuler(S x, S y, S z);
+	static BasicQuaternion fromEuler(const Vec3<S> &euler);
+	static BasicQuaternion fromEuler(const Vector3 &euler);
 
-	Vector3f toEuler(bool degrees = false) const;
+	Vec3<S> toEuler(bool degrees = false) const;
 
-	static rl::Quaternion fromEigRotMatrix(const Matrix4f &matrix);
-	static rl::Quaternion fromRlRotMatrix(const ::Matrix &matrix);
+	/**
+	 * @brief Exponential map, returns the rotation by the angle |theta| about the axis theta / |theta|.
+	 * Needs a floating point scalar, small angles take a series expansion.
+	 *
+	 * @param theta Rotation vector.
+	 */
+	static BasicQuaternion fromRotationVector(const Vec3<S> &theta);
+
+	static BasicQuaternion fromEigRotMatrix(const Mat4<S> &matrix);
+	static BasicQuaternion fromRlRotMatrix(const ::Matrix &matrix);
+
+	/**
+	 * @brief Spherical linear interpolation between two rotations.
+	 *
+	 * @param from Rotation at t = 0.
+	 * @param to Rotation at t = 1.
+	 * @param t Interpolation factor in range [0, 1].
+	 */
+	static BasicQuaternion slerp(const BasicQuaternion &from, const BasicQuaternion &to, S t);
 
 	::Quaternion toRlQuaternion() const;
 	::Matrix toRlRotMatrix() const;
-	Matrix4f toEigRotMatrix() const;
-	Matrix3f toRotationMatrix() const;
-	Vector4f toEigVector() const;
+	Mat4<S> toEigRotMatrix() const;
+	Mat3<S> toRotationMatrix() const;
+	Vec4<S> toEigVector() const;
 	Vector3 toRlVector3() const;
 
-	Vector4f data() const;
+	const Vec4<S> &data() const;
 
-	float magnitude() const;
+	S magnitude() const;
 
-	Quaternion cconjugate() const;
-	Quaternion cnormalize() const;
-	Quaternion ctranspose() const;
-	float dot(const Quaternion &q) const;
+	BasicQuaternion cconjugate() const;
+	BasicQuaternion cnormalize() const;
+	BasicQuaternion ctranspose() const;
+	S dot(const BasicQuaternion &q) const;
 
-	Quaternion &conjugate();
-	Quaternion &normalize();
+	BasicQuaternion &conjugate();
+	BasicQuaternion &normalize();
 
-	Quaternion rotate(const Quaternion &q) const;
-	Quaternion rotate(const Vector3f &v) const;
-	Quaternion rotate(const Vector3 &v) const;
+	BasicQuaternion rotate(const BasicQuaternion &q) const;
+	/**
+	 * @brief Rotates the vector and returns it as a pure quaternion, see rotateVector for the unit norm precondition.
+	 */
+	BasicQuaternion rotate(const Vec3<S> &v) const;
+	BasicQuaternion rotate(const Vector3 &v) const;
+	/**
+	 * @brief Rotates the vector, q * v * q' without forming the pure quaternion of v.
+	 * The fused formula equals q * v * q' only for a unit quaternion, the quaternion has to be normalized.
+	 * Debug builds assert it.
+	 */
+	Vec3<S> rotateVector(const Vec3<S> &v) const;
 
-	Quaternion &operator+=(const Quaternion &rhs);
-	Quaternion &operator-=(const Quaternion &rhs);
-	Quaternion &operator*=(const Quaternion &rhs);
-	Quaternion &operator*=(float rhs);
-	Quaternion &operator/=(const Quaternion &rhs);
+	/**
+	 * @brief Fused in place q += a * x, no temporary quaternion is created.
+	 */
+	BasicQuaternion &axpy(S a, const BasicQuaternion &x);
+	/**
+	 * @brief Advances the rotation by the angular velocity in the body frame over the time step,
+	 * q += dt / 2 * q * [omega, 0]. The product and the update are fused into a single pass over the components.
+	 *
+	 * @param omega Angular velocity in the body frame.
+	 * @param dt Time step.
+	 */
+	BasicQuaternion &integrate(const Vec3<S> &omega, S dt);
 
-private:
+	BasicQuaternion &operator+=(const BasicQuaternion &rhs);
+	BasicQuaternion &operator-=(const BasicQuaternion &rhs);
+	BasicQuaternion &operator*=(const BasicQuaternion &rhs);
+	BasicQuaternion &operator*=(S rhs);
+	BasicQuaternion &operator/=(const BasicQuaternion &rhs);
 
-	Vector4f m_data;
+private:
+	Vec4<S> m_data;
 };
 
-Quaternion operator+(const Quaternion &lhs, const Quaternion &rhs);
-Quaternion operator-(const Quaternion &lhs, const Quaternion &rhs);
-Quaternion operator*(const Quaternion &lhs, const Quaternion &rhs);
-Quaternion operator*(const Quaternion &lhs, double rhs);
-Quaternion operator*(double lhs, const Quaternion& rhs);
-Quaternion operator/(const Quaternion &lhs, const Quaternion &rhs);
-float operator&(const Quaternion &lhs, const Quaternion &rhs);
+using Quaternion = BasicQuaternion<float>;
+using QuaternionD = BasicQuaternion<double>;
+
+template <typename S>
+Vec3<S> BasicQuaternion<S>::rotateVector(const Vec3<S> &v) const
+{
+	// The product q v q* of a pure quaternion v expanded as v + w t + u x t with t = 2 u x v, where u is the vector
+	// part. Written per component, so it stays cheap enough to be inlined into the integration loops.
+	// Non finite rotations pass, the adaptive integrator rejects the steps producing them.
+	using std::abs;
+	assert(!ScalarTraits<S>::any(abs(m_data.squaredNorm() - S(1)) >= S(1e-3f)) && "rotateVector needs a unit quaternion");
+	S x = m_data.x(), y = m_data.y(), z = m_data.z(), w = m_data.w();
+	S tx = S(2) * (y * v.z() - z * v.y());
+	S ty = S(2) * (z * v.x() - x * v.z());
+	S tz = S(2) * (x * v.y() - y * v.x());
+	return Vec3<S>(
+		v.x() + w * tx + (y * tz - z * ty),
+		v.y() + w * ty + (z * tx - x * tz),
+		v.z() + w * tz + (x * ty - y * tx));
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::axpy(S a, const BasicQuaternion &x)
+{
+	m_data += a * x.m_data;
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::integrate(const Vec3<S> &omega, S dt)
+{
+	// Hamilton product with the pure quaternion [omega, 0] expanded, its w * 0 terms drop out.
+	S h = S(0.5f) * dt;
+	S x = m_data.x(), y = m_data.y(), z = m_data.z(), w = m_data.w();
+	m_data = Vec4<S>(
+		x + h * (w * omega.x() + y * omega.z() - z * omega.y()),
+		y + h * (w * omega.y() + z * omega.x() - x * omega.z()),
+		z + h * (w * omega.z() + x * omega.y() - y * omega.x()),
+		w - h * (x * omega.x() + y * omega.y() + z * omega.z()));
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> operator+(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs);
+template <typename S>
+BasicQuaternion<S> operator-(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs);
+template <typename S>
+BasicQuaternion<S> operator*(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs);
+template <typename S>
+BasicQuaternion<S> operator*(const BasicQuaternion<S> &lhs, std::type_identity_t<S> rhs);
+template <typename S>
+BasicQuaternion<S> operator*(std::type_identity_t<S> lhs, const BasicQuaternion<S> &rhs);
+template <typename S>
+BasicQuaternion<S> operator/(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs);
+template <typename S>
+S operator&(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs);
+
+namespace detail
+{
+
+/**
+ * @brief Hamilton product of two quaternions stored as (x, y, z, w).
+ */
+template <typename S>
+Vec4<S> multiply(const Vec4<S> &a, const Vec4<S> &b)
+{
+	return Vec4<S>(
+		a.x() * b.w() + a.w() * b.x() + a.y() * b.z() - a.z() * b.y(),
+		a.y() * b.w() + a.w() * b.y() + a.z() * b.x() - a.x() * b.z(),
+		a.z() * b.w() + a.w() * b.z() + a.x() * b.y() - a.y() * b.x(),
+		a.w() * b.w() - a.x() * b.x() - a.y() * b.y() - a.z() * b.z());
+}
+
+/**
+ * @brief Single precision Hamilton product computed with SSE shuffles, see quaternion.cpp.
+ */
+Vector4f multiply(const Vector4f &a, const Vector4f &b);
+
+/**
+ * @brief Quaternion of the rotation matrix, picks the best conditioned of the four solutions.
+ */
+template <typename S>
+Vec4<S> fromRotation(const Mat3<S> &R)
+{
+	S fourW = R(0, 0) + R(1, 1) + R(2, 2);
+	S fourX = R(0, 0) - R(1, 1) - R(2, 2);
+	S fourY = R(1, 1) - R(0, 0) - R(2, 2);
+	S fourZ = R(2, 2) - R(0, 0) - R(1, 1);
+
+	int biggest = 0;
+	S fourBiggest = fourW;
+	if (fourX > fourBiggest) { fourBiggest = fourX; biggest = 1; }
+	if (fourY > fourBiggest) { fourBiggest = fourY; biggest = 2; }
+	if (fourZ > fourBiggest) { fourBiggest = fourZ; biggest = 3; }
+
+	S value = std::sqrt(fourBiggest + S(1)) * S(0.5f);
+	S mult = S(0.25f) / value;
+
+	switch (biggest) {
+	case 0:
+		return Vec4<S>((R(2, 1) - R(1, 2)) * mult, (R(0, 2) - R(2, 0)) * mult, (R(1, 0) - R(0, 1)) * mult, value);
+	case 1:
+		return Vec4<S>(value, (R(1, 0) + R(0, 1)) * mult, (R(0, 2) + R(2, 0)) * mult, (R(2, 1) - R(1, 2)) * mult);
+	case 2:
+		return Vec4<S>((R(1, 0) + R(0, 1)) * mult, value, (R(2, 1) + R(1, 2)) * mult, (R(0, 2) - R(2, 0)) * mult);
+	default:
+		return Vec4<S>((R(0, 2) + R(2, 0)) * mult, (R(2, 1) + R(1, 2)) * mult, value, (R(1, 0) - R(0, 1)) * mult);
+	}
+}
+
+}
+
+template <typename S>
+Mat3<S> skewMarix(const Vec3<S> &v)
+{
+	Mat3<S> skew;
+	skew << S(0), -v.z(), v.y(),
+			v.z(), S(0), -v.x(),
+			-v.y(), v.x(), S(0);
+	return skew;
+}
+
+template <typename S>
+BasicQuaternion<S>::BasicQuaternion(S x, S y, S z, S w)
+	: m_data{ x, y, z, w }
+{
+}
+
+template <typename S>
+BasicQuaternion<S>::BasicQuaternion(const Vec4<S> &data)
+	: m_data(data)
+{
+}
+
+template <typename S>
+BasicQuaternion<S>::BasicQuaternion(::Quaternion quat)
+	: m_data{ S(quat.x), S(quat.y), S(quat.z), S(quat.w) }
+{
+}
+
+template <typename S>
+template <typename T>
+BasicQuaternion<T> BasicQuaternion<S>::cast() const
+{
+	return BasicQuaternion<T>(m_data.template cast<T>());
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::fromEuler(S x, S y, S z)
+{
+	using std::cos, std::sin;
+
+	// Same convention as raylib QuaternionFromEuler(pitch, yaw, roll).
+	S x0 = cos(x * S(0.5f));
+	S x1 = sin(x * S(0.5f));
+	S y0 = cos(y * S(0.5f));
+	S y1 = sin(y * S(0.5f));
+	S z0 = cos(z * S(0.5f));
+	S z1 = sin(z * S(0.5f));
+
+	return BasicQuaternion(
+		x1 * y0 * z0 - x0 * y1 * z1,
+		x0 * y1 * z0 + x1 * y0 * z1,
+		x0 * y0 * z1 - x1 * y1 * z0,
+		x0 * y0 * z0 + x1 * y1 * z1);
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::fromEuler(const Vec3<S> &euler)
+{
+	return fromEuler(euler.x(), euler.y(), euler.z());
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::fromEuler(const Vector3 &euler)
+{
+	return fromEuler(S(euler.x), S(euler.y), S(euler.z));
+}
+
+template <typename S>
+Vec3<S> BasicQuaternion<S>::toEuler(bool degrees) const
+{
+	S x = m_data.x(), y = m_data.y(), z = m_data.z(), w = m_data.w();
+
+	// Roll, pitch and yaw as raylib QuaternionToEuler computes them.
+	S roll = std::atan2(S(2) * (w * x + y * z), S(1) - S(2) * (x * x + y * y));
+	S pitch = std::asin(std::clamp(S(2) * (w * y - z * x), S(-1), S(1)));
+	S yaw = std::atan2(S(2) * (w * z + x * y), S(1) - S(2) * (y * y + z * z));
+
+	Vec3<S> euler = { pitch, yaw, roll };
+	euler *= (degrees ? S(180) / std::numbers::pi_v<S> : S(1));
+	return euler;
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::fromRotationVector(const Vec3<S> &theta)
+{
+	S angle2 = theta.squaredNorm();
+
+	// sin(angle / 2) / angle and cos(angle / 2), the series avoids dividing by a vanishing angle.
+	S scale, w;
+	if (angle2 < S(1e-8f)) {
+		scale = S(0.5f) - angle2 / S(48);
+		w = S(1) - angle2 / S(8);
+	}
+	else {
+		S angle = std::sqrt(angle2);
+		scale = std::sin(S(0.5f) * angle) / angle;
+		w = std::cos(S(0.5f) * angle);
+	}
+	return BasicQuaternion(scale * theta.x(), scale * theta.y(), scale * theta.z(), w);
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::fromEigRotMatrix(const Mat4<S> &matrix)
+{
+	return BasicQuaternion(detail::fromRotation<S>(matrix.template topLeftCorner<3, 3>()));
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::fromRlRotMatrix(const ::Matrix &matrix)
+{
+	Mat3<float> R{
+		{ matrix.m0, matrix.m4, matrix.m8 },
+		{ matrix.m1, matrix.m5, matrix.m9 },
+		{ matrix.m2, matrix.m6, matrix.m10 },
+	};
+	return BasicQuaternion(detail::fromRotation<S>(R.cast<S>()));
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::slerp(const BasicQuaternion &from, const BasicQuaternion &to, S t)
+{
+	Vec4<S> target = to.m_data;
+	S cosHalfTheta = from.m_data.dot(target);
+
+	// Take the shorter way around.
+	if (cosHalfTheta < S(0)) {
+		target = -target;
+		cosHalfTheta = -cosHalfTheta;
+	}
+
+	if (cosHalfTheta >= S(1)) {
+		return from;
+	}
+	if (cosHalfTheta > S(0.95f)) {
+		// Nearly parallel rotations, the normalized linear interpolation is accurate enough.
+		return BasicQuaternion(from.m_data + t * (target - from.m_data)).normalize();
+	}
+
+	S halfTheta = std::acos(cosHalfTheta);
+	S sinHalfTheta = std::sqrt(S(1) - cosHalfTheta * cosHalfTheta);
+	return BasicQuaternion(
+		(std::sin((S(1) - t) * halfTheta) * from.m_data + std::sin(t * halfTheta) * target) / sinHalfTheta);
+}
+
+template <typename S>
+::Quaternion BasicQuaternion<S>::toRlQuaternion() const
+{
+	return ::Quaternion{ float(m_data.x()), float(m_data.y()), float(m_data.z()), float(m_data.w()) };
+}
+
+template <typename S>
+::Matrix BasicQuaternion<S>::toRlRotMatrix() const
+{
+	float x = float(m_data.x()), y = float(m_data.y()), z = float(m_data.z()), w = float(m_data.w());
+
+	// Same entries as toRotationMatrix, written straight into the row major raylib matrix.
+	return ::Matrix{
+		1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - w * z), 2.0f * (x * z + w * y), 0.0f,
+		2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - w * x), 0.0f,
+		2.0f * (x * z - w * y), 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	};
+}
+
+template <typename S>
+Mat4<S> BasicQuaternion<S>::toEigRotMatrix() const
+{
+	Mat4<S> matrix = Mat4<S>::Identity();
+	matrix.template topLeftCorner<3, 3>() = toRotationMatrix();
+	return matrix;
+}
+
+template <typename S>
+Mat3<S> BasicQuaternion<S>::toRotationMatrix() const
+{
+	S x = m_data.x(), y = m_data.y(), z = m_data.z(), w = m_data.w();
+
+	// Expanded I + 2 w S(eta) + 2 S(eta)^2 of the quaternion with the vector part eta.
+	Mat3<S> R;
+	R << S(1) - S(2) * (y * y + z * z), S(2) * (x * y - w * z), S(2) * (x * z + w * y),
+		S(2) * (x * y + w * z), S(1) - S(2) * (x * x + z * z), S(2) * (y * z - w * x),
+		S(2) * (x * z - w * y), S(2) * (y * z + w * x), S(1) - S(2) * (x * x + y * y);
+	return R;
+}
+
+template <typename S>
+Vec4<S> BasicQuaternion<S>::toEigVector() const
+{
+	return m_data;
+}
+
+template <typename S>
+Vector3 BasicQuaternion<S>::toRlVector3() const
+{
+	return Vector3{ float(m_data.x()), float(m_data.y()), float(m_data.z()) };
+}
+
+template <typename S>
+const Vec4<S> &BasicQuaternion<S>::data() const
+{
+	return m_data;
+}
+
+template <typename S>
+S BasicQuaternion<S>::magnitude() const
+{
+	return m_data.norm();
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::cconjugate() const
+{
+	BasicQuaternion q = *this;
+	q.conjugate();
+	return q;
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::cnormalize() const
+{
+	BasicQuaternion q = *this;
+	q.normalize();
+	return q;
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::ctranspose() const
+{
+	BasicQuaternion conj = *this;
+	conj.m_data.transpose();
+
+	return conj;
+}
+
+template <typename S>
+S BasicQuaternion<S>::dot(const BasicQuaternion &q) const
+{
+	return m_data.dot(q.m_data);
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::conjugate()
+{
+	// A single packed multiplication flips the vector part.
+	m_data = m_data.cwiseProduct(Vec4<S>(S(-1), S(-1), S(-1), S(1)));
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::normalize()
+{
+	S mag = magnitude();
+	m_data *= S(1) / ScalarTraits<S>::select(mag == S(0), S(1), mag);
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::rotate(const BasicQuaternion &q) const
+{
+	return *this * (q * cconjugate());
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::rotate(const Vec3<S> &v) const
+{
+	Vec3<S> rotated = rotateVector(v);
+	return BasicQuaternion(rotated.x(), rotated.y(), rotated.z(), S(0));
+}
+
+template <typename S>
+BasicQuaternion<S> BasicQuaternion<S>::rotate(const Vector3 &v) const
+{
+	return rotate(Vec3<S>(S(v.x), S(v.y), S(v.z)));
+}
+
+template <typename S>
+BasicQuaternion<S> operator+(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+	return BasicQuaternion<S>(lhs.data() + rhs.data());
+}
+
+template <typename S>
+BasicQuaternion<S> operator-(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+	return BasicQuaternion<S>(lhs.data() - rhs.data());
+}
+
+template <typename S>
+BasicQuaternion<S> operator*(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+	return BasicQuaternion<S>(detail::multiply(lhs.data(), rhs.data()));
+}
+
+template <typename S>
+BasicQuaternion<S> operator*(const BasicQuaternion<S> &lhs, std::type_identity_t<S> rhs)
+{
+	return BasicQuaternion<S>(lhs.data() * rhs);
+}
+
+template <typename S>
+BasicQuaternion<S> operator*(std::type_identity_t<S> lhs, const BasicQuaternion<S> &rhs)
+{
+	return BasicQuaternion<S>(rhs.data() * lhs);
+}
+
+template <typename S>
+BasicQuaternion<S> operator/(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+	return lhs * rhs.cconjugate();
+}
+
+template <typename S>
+S operator&(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+	return lhs.magnitude() * rhs.magnitude();
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::operator+=(const BasicQuaternion &rhs)
+{
+	m_data += rhs.m_data;
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::operator-=(const BasicQuaternion &rhs)
+{
+	m_data -= rhs.m_data;
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::operator*=(const BasicQuaternion &rhs)
+{
+	m_data = detail::multiply(m_data, rhs.m_data);
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::operator*=(S rhs)
+{
+	m_data *= rhs;
+	return *this;
+}
+
+template <typename S>
+BasicQuaternion<S> &BasicQuaternion<S>::operator/=(const BasicQuaternion &rhs)
+{
+	*this = *this / rhs;
+	return *this;
+}
+
 } // namespace RLC
 
-template <>
-struct std::formatter<rl::Quaternion> {
+template <typename S>
+struct std::formatter<rl::BasicQuaternion<S>> {
 	constexpr auto parse(std::format_parse_context& ctx) { return ctx.begin(); }
 
 	template <typename FormatContext>
-	auto format(const rl::Quaternion& p, FormatContext& ctx) const {
-		auto data = p.data();
+	auto format(const rl::BasicQuaternion<S>& p, FormatContext& ctx) const {
+		const auto &data = p.data();
 		return std::format_to(ctx.out(), "Quaternion (xyzw)  [{}, {}, {}, {}]", data.x(), data.y(), data.z(), data.w());
 	}
 };
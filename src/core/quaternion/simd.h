@@ -0,0 +1,61 @@
+#pragma once
+
+#include <experimental/simd>
+
+#include "quaternion.h"
+
+namespace rl
+{
+
+// Native SIMD packs of the target, a rl::BasicQuaternion of a pack holds one quaternion per lane.
+using FloatPack = std::experimental::native_simd<float>;
+using DoublePack = std::experimental::native_simd<double>;
+
+template <typename T, typename Abi>
+struct ScalarTraits<std::experimental::simd<T, Abi>>
+{
+	using Pack = std::experimental::simd<T, Abi>;
+
+	/**
+	 * @brief Returns lhs in the lanes where the condition holds and rhs in the others.
+	 */
+	static Pack select(const typename Pack::mask_type &condition, Pack lhs, Pack rhs)
+	{
+		std::experimental::where(condition, rhs) = lhs;
+		return rhs;
+	}
+
+	/**
+	 * @brief Returns true if the condition holds in any lane.
+	 */
+	static bool any(const typename Pack::mask_type &condition)
+	{
+		return std::experimental::any_of(condition);
+	}
+};
+
+}
+
+/**
+ * @brief Lets the packs be the scalar of the fixed size Eigen matrices. Eigen does not vectorize them further,
+ * the pack operations already use the vector registers.
+ */
+template <typename T, typename Abi>
+struct Eigen::NumTraits<std::experimental::simd<T, Abi>> : Eigen::GenericNumTraits<T>
+{
+	using Real = std::experimental::simd<T, Abi>;
+	using NonInteger = Real;
+	using Literal = Real;
+	using Nested = Real;
+
+	enum
+	{
+		IsComplex = 0,
+		IsInteger = 0,
+		IsSigned = 1,
+		RequireInitialization = 1,
+		ReadCost = 1,
+		AddCost = 1,
+		MulCost = 1,
+	};
+};
@@ -0,0 +1,235 @@
+#include "scenario.h"
+
+#include <array>
+#include <fstream>
+#include <print>
+#include <random>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "body.h"
+#include "factory.h"
+#include "trace.h"
+
+using nlohmann::json;
+
+/**
+ * @brief Reads a vector stored as an array of three numbers, returns the fallback if the key is missing.
+ */
+static Vector3 readVector3(const json &object, const char *key, const Vector3 &fallback)
+{
+	auto it = object.find(key);
+	if (it == object.end()) {
+		return fallback;
+	}
+
+	auto read = it->get<std::array<float, 3>>();
+	return Vector3{ read[0], read[1], read[2] };
+}
+
+rl::Scenario rl::Scenario::fromFile(const rl::Path &path)
+{
+	RL_TRACE_SCOPE("Scenario::fromFile");
+	std::println("Loading scenario from: {}", path.string());
+
+	std::ifstream file(path.string(), std::ifstream::in);
+	if (!file.is_open()) {
+		throw std::runtime_error("Scenario file [" + path.string() + "] not found");
+	}
+
+	Scenario scenario;
+	const Vector3 zero{ 0.0f, 0.0f, 0.0f };
+
+	// Section of the document the parser is in and the name of the archetype being declared.
+	std::string section;
+	std::string name;
+
+	auto declare = [&](const json &value) {
+		auto &archetype = scenario.m_archetypes[scenario.archetype(name)];
+		if (archetype.declared) {
+			throw std::runtime_error("Archetype [" + name + "] is declared twice in [" + path.string() + "]");
+		}
+		archetype.type = value.at("type").get<std::string>();
+		archetype.model = rl::Model::fromFile(path.parent_path() / value.at("config").get<std::string>());
+		archetype.declared = true;
+	};
+
+	auto precision = [&](const json &value) {
+		auto read = value.get<std::string>();
+		if (read == "float") {
+			scenario.m_precision = rl::Precision::Float;
+		}
+		else if (read == "double") {
+			scenario.m_precision = rl::Precision::Double;
+		}
+		else {
+			throw std::runtime_error("Unknown precision [" + read + "] in [" + path.string() + "]");
+		}
+	};
+
+	auto place = [&](const json &value) {
+		scenario.m_placements.push_back(Placement{
+			.archetype = scenario.archetype(value.at("archetype").get<std::string>()),
+			.position = readVector3(value, "position", zero),
+			.rotation = readVector3(value, "rotation", zero),
+			.hasPosition = value.contains("position"),
+			.hasRotation = value.contains("rotation"),
+		});
+	};
+
+	auto grid = [&](const json &value) {
+		uint32_t archetype = scenario.archetype(value.at("archetype").get<std::string>());
+		auto count = value.at("count").get<std::array<size_t, 3>>();
+		Vector3 origin = readVector3(value, "origin", zero);
+		Vector3 spacing = readVector3(value, "spacing", Vector3{ 1.0f, 1.0f, 1.0f });
+		Vector3 rotation = readVector3(value, "rotation", zero);
+
+		scenario.m_placements.reserve(scenario.m_placements.size() + count[0] * count[1] * count[2]);
+		for (size_t x = 0; x < count[0]; ++x) {
+			for (size_t y = 0; y < count[1]; ++y) {
+				for (size_t z = 0; z < count[2]; ++z) {
+					Vector3 position{ origin.x + x * spacing.x, origin.y + y * spacing.y, origin.z + z * spacing.z };
+					scenario.m_placements.push_back(Placement{ archetype, position, rotation, true, value.contains("rotation") });
+				}
+			}
+		}
+	};
+
+	auto scatter = [&](const json &value) {
+		uint32_t archetype = scenario.archetype(value.at("archetype").get<std::string>());
+		size_t count = value.at("count").get<size_t>();
+		Vector3 min = readVector3(value, "min", zero);
+		Vector3 max = readVector3(value, "max", zero);
+		Vector3 rotation = readVector3(value, "rotation", zero);
+
+		std::mt19937 generator(value.value("seed", 0u));
+		std::uniform_real_distribution<float> x(min.x, max.x);
+		std::uniform_real_distribution<float> y(min.y, max.y);
+		std::uniform_real_distribution<float> z(min.z, max.z);
+
+		scenario.m_placements.reserve(scenario.m_placements.size() + count);
+		for (size_t i = 0; i < count; ++i) {
+			Vector3 position{ x(generator), y(generator), z(generator) };
+			scenario.m_placements.push_back(Placement{ archetype, position, rotation, true, value.contains("rotation") });
+		}
+	};
+
+	// Every element of the sections is consumed once it is parsed and dropped from the document right away.
+	json::parser_callback_t callback = [&](int depth, json::parse_event_t event, json &parsed) {
+		if (event == json::parse_event_t::key && depth == 1) {
+			section = parsed.get<std::string>();
+			if (section != "precision" && section != "integrator" && section != "archetypes" && section != "instances"
+				&& section != "grids" && section != "random") {
+				std::println("[Warning]: Unknown scenario section: {}", section);
+			}
+			return true;
+		}
+		if (event == json::parse_event_t::value && depth == 1 && section == "precision") {
+			precision(parsed);
+			return true;
+		}
+		if (event == json::parse_event_t::value && depth == 1 && section == "integrator") {
+			scenario.m_integrator = rl::integratorFromName(parsed.get<std::string>());
+			return true;
+		}
+		if (event == json::parse_event_t::key && depth == 2) {
+			name = parsed.get<std::string>();
+			return true;
+		}
+		if (event != json::parse_event_t::object_end || depth != 2) {
+			return true;
+		}
+
+		if (section == "archetypes") {
+			declare(parsed);
+		}
+		else if (section == "instances") {
+			place(parsed);
+		}
+		else if (section == "grids") {
+			grid(parsed);
+		}
+		else if (section == "random") {
+			scatter(parsed);
+		}
+		return false;
+	};
+	// The callback consumes the sections and discards them, the returned document is empty.
+	(void)json::parse(file, callback);
+
+	for (const auto &archetype : scenario.m_archetypes) {
+		if (!archetype.declared) {
+			throw std::runtime_error("Archetype [" + archetype.name + "] is not declared in [" + path.string() + "]");
+		}
+	}
+
+	std::println("Loaded scenario with {} archetypes and {} objects in {} precision", scenario.m_archetypes.size(),
+		scenario.size(), scenario.m_precision == rl::Precision::Float ? "float" : "double");
+	return scenario;
+}
+
+size_t rl::Scenario::size() const
+{
+	return m_placements.size();
+}
+
+rl::Precision rl::Scenario::precision() const
+{
+	return m_precision;
+}
+
+rl::Integrator rl::Scenario::integrator() const
+{
+	return m_integrator;
+}
+
+std::vector<rl::Object::Ptr> rl::Scenario::instantiate() const
+{
+	RL_TRACE_SCOPE("Scenario::instantiate");
+	auto &factory = rl::ObjectFactory::instance();
+	for (const auto &archetype : m_archetypes) {
+		if (!factory.contains(archetype.type)) {
+			throw std::runtime_error("Unknown object type [" + archetype.type + "] of archetype [" + archetype.name + "]");
+		}
+	}
+
+	rl::withBodyStore(m_precision, [this](auto &store) { store.reserve(store.size() + m_placements.size()); });
+	std::vector<size_t> counts(m_archetypes.size(), 0);
+	for (const auto &placement : m_placements) {
+		++counts[placement.archetype];
+	}
+	for (size_t i = 0; i < m_archetypes.size(); ++i) {
+		factory.reserve(m_archetypes[i].type, counts[i]);
+	}
+
+	std::vector<rl::Object::Ptr> objects;
+	objects.reserve(m_placements.size());
+
+	rl::Model model;
+	for (const auto &placement : m_placements) {
+		const auto &archetype = m_archetypes[placement.archetype];
+		model = archetype.model;
+		model.precision = m_precision;
+		if (placement.hasPosition) {
+			model.position = placement.position;
+		}
+		if (placement.hasRotation) {
+			model.rotation = placement.rotation;
+		}
+		objects.push_back(factory.create(archetype.type, model));
+	}
+	return objects;
+}
+
+uint32_t rl::Scenario::archetype(const std::string &name)
+{
+	for (uint32_t i = 0; i < m_archetypes.size(); ++i) {
+		if (m_archetypes[i].name == name) {
+			return i;
+		}
+	}
+
+	m_archetypes.push_back(Archetype{ .name = name, .type = {}, .model = {}, .declared = false });
+	return m_archetypes.size() - 1;
+}
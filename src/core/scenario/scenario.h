@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <raylib.h>
+
+#include "loader.h"
+#include "object.h"
+
+namespace rl
+{
+
+/**
+ * @class Scenario
+ * @brief Set of objects to be spawned, declared as archetypes and their placements.
+ *
+ * The archetypes are declared once, every placement only refers to its archetype by name. The objects are placed
+ * one by one in the instances array or by the grid and random rules:
+ *
+ * @code{.json}
+ * {
+ *     "precision": "float",
+ *     "integrator": "rk4",
+ *     "archetypes": {
+ *         "drone": { "type": "drone", "config": "../drone.json" }
+ *     },
+ *     "instances": [
+ *         { "archetype": "drone", "position": [0, 0, 0], "rotation": [0, 0, 0] }
+ *     ],
+ *     "grids": [
+ *         { "archetype": "drone", "count": [10, 1, 10], "origin": [0, 0, 0], "spacing": [5, 5, 5] }
+ *     ],
+ *     "random": [
+ *         { "archetype": "drone", "count": 100, "min": [-50, 0, -50], "max": [50, 20, 50], "seed": 1 }
+ *     ]
+ * }
+ * @endcode
+ *
+ * The type of an archetype is the name it is registered under in rl::ObjectFactory, the config is the path of its
+ * model configuration relative to the scenario file. The precision is the scalar type the rigid bodies of all
+ * the objects are integrated in, "float" or "double", float if it is omitted. The integrator is the scheme of
+ * the kinematics, see rl::integratorFromName for the names, euler if it is omitted. Instances without a position or rotation keep the one of the
+ * configuration. The file is parsed in a single pass, every placement is consumed as soon as it is parsed,
+ * so the document is never held in memory as a whole.
+ */
+class Scenario
+{
+public:
+	/**
+	 * @brief Loads the scenario from a file.
+	 *
+	 * @param path Path to the scenario file.
+	 * @return Scenario The parsed scenario.
+	 */
+	static Scenario fromFile(const rl::Path &path);
+
+	/**
+	 * @brief Returns the number of objects the scenario spawns.
+	 */
+	size_t size() const;
+	/**
+	 * @brief Returns the precision the bodies of the scenario objects are integrated in.
+	 */
+	rl::Precision precision() const;
+	/**
+	 * @brief Returns the scheme the poses of the scenario objects are integrated with.
+	 */
+	rl::Integrator integrator() const;
+	/**
+	 * @brief Creates all the objects of the scenario through rl::ObjectFactory.
+	 *
+	 * @return std::vector<rl::Object::Ptr> The created objects, in the order they are declared.
+	 */
+	std::vector<rl::Object::Ptr> instantiate() const;
+
+private:
+	struct Archetype
+	{
+		std::string name;
+		std::string type;
+		rl::Model model;
+		// False until the archetype is declared, placements may refer to it before that.
+		bool declared = false;
+	};
+
+	struct Placement
+	{
+		uint32_t archetype;
+		Vector3 position;
+		Vector3 rotation;
+		// Whether the placement overrides the pose of the archetype configuration.
+		bool hasPosition;
+		bool hasRotation;
+	};
+
+	/**
+	 * @brief Returns the index of the archetype, it is added undeclared if it is not known yet.
+	 */
+	uint32_t archetype(const std::string &name);
+
+private:
+	std::vector<Archetype> m_archetypes;
+	std::vector<Placement> m_placements;
+	rl::Precision m_precision = rl::Precision::Float;
+	rl::Integrator m_integrator = rl::Integrator::Euler;
+};
+
+}
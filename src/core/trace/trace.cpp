@@ -0,0 +1,129 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <vector>
+
+namespace
+{
+
+// Number of zones kept per thread, the oldest are overwritten first.
+constexpr size_t BUFFER_SIZE = 1 << 16;
+
+struct Event
+{
+	const char *name;
+	uint64_t start;
+	uint64_t duration;
+};
+
+/**
+ * @brief Ring buffer of the zones recorded by a single thread.
+ * Only the owning thread writes into the buffer, the write counter publishes the events to the dump.
+ */
+struct Buffer
+{
+	explicit Buffer(size_t thread)
+		: thread(thread)
+		, events(BUFFER_SIZE)
+	{
+	}
+
+	size_t thread;
+	std::vector<Event> events;
+	std::atomic<uint64_t> written{ 0 };
+};
+
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<Buffer>> buffers;
+const auto epoch = std::chrono::steady_clock::now();
+
+uint64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+Buffer &threadBuffer()
+{
+	thread_local Buffer *buffer = nullptr;
+	if (buffer == nullptr) {
+		std::lock_guard lock(buffersMutex);
+		buffers.push_back(std::make_unique<Buffer>(buffers.size()));
+		buffer = buffers.back().get();
+	}
+	return *buffer;
+}
+
+}
+
+rl::trace::Zone::Zone(const char *name)
+	: m_name(name)
+	, m_start(now())
+{
+}
+
+rl::trace::Zone::~Zone()
+{
+	uint64_t end = now();
+	Buffer &buffer = threadBuffer();
+
+	uint64_t written = buffer.written.load(std::memory_order_relaxed);
+	buffer.events[written % BUFFER_SIZE] = Event{ m_name, m_start, end - m_start };
+	buffer.written.store(written + 1, std::memory_order_release);
+}
+
+bool rl::trace::dump(const std::filesystem::path &path)
+{
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		std::println("[Error]: Could not open trace file: {}", path.string());
+		return false;
+	}
+
+	std::lock_guard lock(buffersMutex);
+	size_t count = 0;
+
+	file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	for (const auto &buffer : buffers) {
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t first = written > BUFFER_SIZE ? written - BUFFER_SIZE : 0;
+
+		for (uint64_t i = first; i < written; ++i) {
+			const Event &event = buffer->events[i % BUFFER_SIZE];
+			// Chrome trace timestamps are in microseconds.
+			file << (count++ == 0 ? "" : ",\n")
+				<< std::format(R"({{"name": "{}", "ph": "X", "pid": 1, "tid": {}, "ts": {:.3f}, "dur": {:.3f}}})",
+					event.name, buffer->thread, event.start / 1000.0, event.duration / 1000.0);
+		}
+	}
+	file << "\n]}\n";
+
+	std::println("Written {} trace zones to {}", count, path.string());
+	return true;
+}
+
+void rl::FrameStats::push(float seconds)
+{
+	m_frames[m_next] = seconds;
+	m_next = (m_next + 1) % WINDOW;
+	m_count = std::min(m_count + 1, WINDOW);
+}
+
+float rl::FrameStats::percentile(float percentile) const
+{
+	if (m_count == 0) {
+		return 0.0f;
+	}
+
+	std::array<float, WINDOW> sorted = m_frames;
+	size_t rank = std::lround(std::clamp(percentile, 0.0f, 100.0f) / 100.0f * (m_count - 1));
+	std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + m_count);
+	return sorted[rank];
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#define RL_TRACE_CONCAT_IMPL(a, b) a##b
+#define RL_TRACE_CONCAT(a, b) RL_TRACE_CONCAT_IMPL(a, b)
+
+/**
+ * @brief Records the enclosing scope as a trace zone with the given name.
+ * The name has to be a string literal. Expands to nothing when the tracing is compiled out
+ * with RL_TRACE_DISABLED (CMake option RL_ENABLE_TRACE).
+ */
+#ifdef RL_TRACE_DISABLED
+#define RL_TRACE_SCOPE(name)
+#else
+#define RL_TRACE_SCOPE(name) rl::trace::Zone RL_TRACE_CONCAT(rlTraceZone, __LINE__)(name)
+#endif
+
+namespace rl::trace
+{
+
+/**
+ * @class Zone
+ * @brief RAII timer recording the lifetime of the scope into the buffer of the calling thread.
+ *
+ * Every thread writes into its own fixed size ring buffer, recording a zone takes no lock and
+ * allocates nothing once the buffer of the thread exists. The oldest zones are overwritten when
+ * the buffer is full.
+ */
+class Zone
+{
+public:
+	explicit Zone(const char *name);
+	Zone(const Zone &) = delete;
+	Zone &operator=(const Zone &) = delete;
+	~Zone();
+
+private:
+	const char *m_name;
+	uint64_t m_start;
+};
+
+/**
+ * @brief Writes all the recorded zones into a Chrome trace JSON file.
+ * The file can be opened in chrome://tracing or https://ui.perfetto.dev. Should be called when no
+ * zones are being recorded.
+ *
+ * @param path Path of the written file.
+ * @return bool True if the file was written.
+ */
+bool dump(const std::filesystem::path &path);
+
+}
+
+namespace rl
+{
+
+/**
+ * @class FrameStats
+ * @brief Sliding window of the latest frame times and their percentiles.
+ */
+class FrameStats
+{
+public:
+	// Number of frames the percentiles are computed from.
+	static constexpr size_t WINDOW = 240;
+
+	/**
+	 * @brief Adds the duration of a frame to the window.
+	 *
+	 * @param seconds Frame time in seconds.
+	 */
+	void push(float seconds);
+
+	/**
+	 * @brief Returns the frame time percentile of the window in seconds.
+	 *
+	 * @param percentile Percentile in range [0, 100].
+	 */
+	float percentile(float percentile) const;
+
+private:
+	std::array<float, WINDOW> m_frames{};
+	size_t m_count = 0;
+	size_t m_next = 0;
+};
+
+}
@@ -0,0 +1,109 @@
+#include "watcher.h"
+
+#include <array>
+#include <cstdint>
+#include <print>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+rl::FileWatcher::FileWatcher(Callback callback)
+	: m_callback(std::move(callback))
+	, m_inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+	, m_wake(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+	if (m_inotify < 0 || m_wake < 0) {
+		std::println("[Warning]: File watching is not available, hot reload is disabled");
+		return;
+	}
+	m_thread = std::thread([this]() { loop(); });
+}
+
+rl::FileWatcher::~FileWatcher()
+{
+	if (m_thread.joinable()) {
+		uint64_t one = 1;
+		[[maybe_unused]] auto written = ::write(m_wake, &one, sizeof(one));
+		m_thread.join();
+	}
+
+	if (m_inotify >= 0) {
+		::close(m_inotify);
+	}
+	if (m_wake >= 0) {
+		::close(m_wake);
+	}
+}
+
+bool rl::FileWatcher::watch(const std::filesystem::path &file)
+{
+	if (m_inotify < 0) {
+		return false;
+	}
+
+	std::error_code error;
+	auto path = std::filesystem::weakly_canonical(file, error);
+	if (error) {
+		return false;
+	}
+
+	// Watching a directory again returns its existing descriptor.
+	int descriptor = inotify_add_watch(m_inotify, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (descriptor < 0) {
+		std::println("[Warning]: Cannot watch the directory: {}", path.parent_path().string());
+		return false;
+	}
+
+	std::lock_guard lock(m_mutex);
+	m_directories[descriptor] = path.parent_path();
+	m_files.insert(path);
+	return true;
+}
+
+void rl::FileWatcher::loop()
+{
+	// Large enough for a burst of events, the events are aligned like the inotify_event itself.
+	alignas(inotify_event) std::array<char, 4096> buffer;
+	std::array<pollfd, 2> descriptors{ pollfd{ m_inotify, POLLIN, 0 }, pollfd{ m_wake, POLLIN, 0 } };
+
+	while (true) {
+		if (::poll(descriptors.data(), descriptors.size(), -1) < 0 || descriptors[1].revents != 0) {
+			return;
+		}
+
+		ssize_t length = ::read(m_inotify, buffer.data(), buffer.size());
+		if (length <= 0) {
+			continue;
+		}
+
+		RL_TRACE_SCOPE("FileWatcher::changes");
+		// Editors often write a file in several steps, each changed file is reported once per burst.
+		std::set<std::filesystem::path> changed;
+		for (ssize_t offset = 0; offset < length;) {
+			const auto *event = reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+			if (event->len == 0) {
+				continue;
+			}
+
+			std::lock_guard lock(m_mutex);
+			auto directory = m_directories.find(event->wd);
+			if (directory == m_directories.end()) {
+				continue;
+			}
+
+			auto path = directory->second / event->name;
+			if (m_files.contains(path)) {
+				changed.insert(path);
+			}
+		}
+
+		for (const auto &path : changed) {
+			m_callback(path);
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace rl
+{
+
+/**
+ * @class FileWatcher
+ * @brief Watches files for changes with inotify and reports them on its own thread.
+ *
+ * The directories of the files are watched rather than the files themselves, so a file replaced by an editor
+ * (written to a temporary file and renamed) is still reported. A change is reported once the file is closed
+ * after writing or moved into place.
+ */
+class FileWatcher
+{
+public:
+	using Callback = std::function<void(const std::filesystem::path &)>;
+
+	/**
+	 * @brief Starts the watcher thread.
+	 *
+	 * @param callback Called on the watcher thread with the path of every changed file.
+	 */
+	explicit FileWatcher(Callback callback);
+	FileWatcher(const FileWatcher &) = delete;
+	FileWatcher &operator=(const FileWatcher &) = delete;
+	~FileWatcher();
+
+	/**
+	 * @brief Starts watching the file. Watching a file twice has no effect.
+	 *
+	 * @param file Path of the file.
+	 * @return bool False if the directory of the file cannot be watched.
+	 */
+	bool watch(const std::filesystem::path &file);
+
+private:
+	/**
+	 * @brief Reads the inotify events until the watcher is destroyed.
+	 */
+	void loop();
+
+private:
+	Callback m_callback;
+	// Inotify instance and the event descriptor waking the thread up on destruction.
+	int m_inotify = -1;
+	int m_wake = -1;
+
+	std::mutex m_mutex;
+	// Watched directories by their watch descriptor and the watched files in them.
+	std::map<int, std::filesystem::path> m_directories;
+	std::set<std::filesystem::path> m_files;
+
+	std::thread m_thread;
+};
+
+}
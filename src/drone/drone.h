@@ -1,19 +1,17 @@
 #pragma once
 
+#include "lane.h"
 #include "object.h"
 #include "quaternion.h"
 
-class Drone
+class Drone final
 	: public rl::Object
 {
 public:
-	static rl::Object::Ptr create(const rl::Model& model)
-	{
-		return std::make_shared<Drone>(model);
-	}
-
 	Drone(const rl::Model& model);
 	~Drone();
 
-	Vector6f getTorque();
+	Vector6f getTorque(const rl::InputState &input, const rl::ControlStep &step) override;
 };
+
+extern template class rl::TypedLane<Drone>;
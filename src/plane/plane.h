@@ -1,19 +1,17 @@
 #pragma once
 
+#include "lane.h"
 #include "object.h"
 #include "quaternion.h"
 
-class Plane
+class Plane final
 	: public rl::Object
 {
 public:
-	static rl::Object::Ptr create(const rl::Model& model)
-	{
-		return std::make_shared<Plane>(model);
-	}
-
 	Plane(const rl::Model& model);
 	~Plane();
 
-	Vector6f getTorque() override;
+	Vector6f getTorque(const rl::InputState &input, const rl::ControlStep &step) override;
 };
+
+extern template class rl::TypedLane<Plane>;
@@ -1,19 +1,17 @@
 #pragma once
 
+#include "lane.h"
 #include "object.h"
 #include "quaternion.h"
 
-class Spaceship
+class Spaceship final
 	: public rl::Object
 {
 public:
-	static rl::Object::Ptr create(const rl::Model& model)
-	{
-		return std::make_shared<Spaceship>(model);
-	}
-
 	Spaceship(const rl::Model& model);
 	~Spaceship();
 
-	Vector6f getTorque() override;
+	Vector6f getTorque(const rl::InputState &input, const rl::ControlStep &step) override;
 };
+
+extern template class rl::TypedLane<Spaceship>;
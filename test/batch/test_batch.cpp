@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <print>
+#include <random>
+#include <vector>
+#include "test_batch.h"
+
+/**
+ * @brief Structure-of-arrays storage behind the spans of the batch kernels.
+ */
+struct Components
+{
+	std::vector<float> x, y, z, w;
+
+	explicit Components(size_t count) : x(count), y(count), z(count), w(count) {}
+
+	rl::quatbatch::Quaternions quaternions() { return { x.data(), y.data(), z.data(), w.data() }; }
+	rl::quatbatch::Vectors vectors() { return { x.data(), y.data(), z.data() }; }
+	rl::Quaternion quaternion(size_t i) const { return rl::Quaternion(x[i], y[i], z[i], w[i]); }
+	Vector3f vector(size_t i) const { return Vector3f(x[i], y[i], z[i]); }
+};
+
+static void expectNear(float actual, float expected, const char *what, size_t i)
+{
+	constexpr float TOLERANCE = 1e-5f;
+	if (std::abs(actual - expected) > TOLERANCE * std::max(1.0f, std::abs(expected))) {
+		std::println("[Error]: {} differs at {}: {} != {}", what, i, actual, expected);
+		assert(false);
+	}
+}
+
+static void expectNear(const rl::Quaternion &actual, const rl::Quaternion &expected, const char *what, size_t i)
+{
+	expectNear(actual.x(), expected.x(), what, i);
+	expectNear(actual.y(), expected.y(), what, i);
+	expectNear(actual.z(), expected.z(), what, i);
+	expectNear(actual.w(), expected.w(), what, i);
+}
+
+static void expectNear(const Vector3f &actual, const Vector3f &expected, const char *what, size_t i)
+{
+	expectNear(actual.x(), expected.x(), what, i);
+	expectNear(actual.y(), expected.y(), what, i);
+	expectNear(actual.z(), expected.z(), what, i);
+}
+
+void test_batch()
+{
+	// Two full AVX2 registers and a tail of three elements for the scalar kernels.
+	constexpr size_t COUNT = 19;
+
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> uniform(-2.0f, 2.0f);
+	auto fill = [&](Components &c) {
+		for (size_t i = 0; i < COUNT; ++i) {
+			c.x[i] = uniform(generator);
+			c.y[i] = uniform(generator);
+			c.z[i] = uniform(generator);
+			c.w[i] = uniform(generator);
+		}
+	};
+
+	Components a(COUNT), b(COUNT), v(COUNT);
+	fill(a);
+	fill(b);
+	fill(v);
+	std::println("Batch kernels use AVX2: {}", rl::quatbatch::avx2());
+
+	Components product(COUNT);
+	rl::quatbatch::multiply(a.quaternions(), b.quaternions(), product.quaternions(), COUNT);
+	for (size_t i = 0; i < COUNT; ++i) {
+		expectNear(product.quaternion(i), a.quaternion(i) * b.quaternion(i), "multiply", i);
+	}
+
+	Components unit = a;
+	rl::quatbatch::normalize(unit.quaternions(), COUNT);
+	for (size_t i = 0; i < COUNT; ++i) {
+		expectNear(unit.quaternion(i), a.quaternion(i).cnormalize(), "normalize", i);
+	}
+
+	Components rotated(COUNT);
+	rl::quatbatch::rotate(unit.quaternions(), v.vectors(), rotated.vectors(), COUNT);
+	for (size_t i = 0; i < COUNT; ++i) {
+		expectNear(rotated.vector(i), unit.quaternion(i).rotateVector(v.vector(i)), "rotate", i);
+	}
+
+	rl::Quaternion q = unit.quaternion(0);
+	rl::quatbatch::rotate(q, v.vectors(), rotated.vectors(), COUNT);
+	for (size_t i = 0; i < COUNT; ++i) {
+		expectNear(rotated.vector(i), q.rotateVector(v.vector(i)), "rotate by one quaternion", i);
+	}
+
+	std::vector<::Matrix> matrices(COUNT);
+	rl::quatbatch::toMatrices(unit.quaternions(), matrices.data(), COUNT);
+	for (size_t i = 0; i < COUNT; ++i) {
+		::Matrix expected = unit.quaternion(i).toRlRotMatrix();
+		const float *actualData = &matrices[i].m0, *expectedData = &expected.m0;
+		for (size_t k = 0; k < 16; ++k) {
+			expectNear(actualData[k], expectedData[k], "toMatrices", i);
+		}
+	}
+
+	std::println("Batch kernels match rl::Quaternion for {} elements.", COUNT);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "batch.h"
+
+void test_batch();
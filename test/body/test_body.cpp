@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "test_body.h"
+
+/**
+ * @brief Integrates a body in the store and with the dense 6x6 rigid body equations, the velocities of every
+ * step have to match.
+ */
+template <typename S>
+static void compareWithDense(float mass, const Matrix3f &inertia, const Vector6f &tau, S tolerance)
+{
+	constexpr float dt = 1.0f / 240.0f;
+	auto &store = rl::BasicBodyStore<S>::instance();
+	auto handle = store.add(Vector3{ 0, 0, 0 }, rl::Quaternion(0, 0, 0, 1), mass, inertia);
+	store.setTorque(handle, tau);
+
+	rl::Mat6<S> Mrb = rl::Mat6<S>::Zero();
+	Mrb.template block<3, 3>(0, 0) = rl::Mat3<S>::Identity() * S(mass);
+	Mrb.template block<3, 3>(3, 3) = inertia.cast<S>();
+	rl::Mat6<S> invMrb = Mrb.inverse();
+
+	rl::Vec6<S> feedback = rl::Vec6<S>::Zero();
+	rl::Vec6<S> nu;
+	S error = 0;
+	for (int step = 0; step < 100; ++step) {
+		nu = invMrb * (tau.cast<S>() - feedback) * S(dt);
+		rl::Vec3<S> v = nu.template head<3>();
+		rl::Vec3<S> omega = nu.template tail<3>();
+		feedback << omega.cross(S(mass) * v), -1 * (inertia.cast<S>() * omega).cross(omega);
+
+		store.integrate(dt);
+
+		Vector6f velocity = store.velocity(handle);
+		for (int c = 0; c < 6; ++c) {
+			error = std::max(error, std::abs(S(velocity[c]) - nu[c]) / std::max(S(1), std::abs(nu[c])));
+		}
+	}
+
+	std::println("Velocity after 100 steps: [{}, {}, {}, {}, {}, {}], largest error to the dense path: {}",
+		nu[0], nu[1], nu[2], nu[3], nu[4], nu[5], error);
+	assert(error <= tolerance);
+	store.remove(handle);
+}
+
+/**
+ * @brief A body driven by a non finite torque has to finish the adaptive step and keep its last finite pose.
+ */
+static void adaptiveStepRejectsNan()
+{
+	auto &store = rl::BodyStore::instance();
+	store.setIntegrator(rl::Integrator::RungeKutta45);
+	auto handle = store.add(Vector3{ 1, 2, 3 }, rl::Quaternion(0, 0, 0, 1), 1.0f, Matrix3f::Identity());
+
+	Vector6f tau = Vector6f::Constant(std::nanf(""));
+	store.setTorque(handle, tau);
+	store.integrate(1.0f / 240.0f);
+
+	Vector3 position = store.position(handle);
+	rl::Quaternion rotation = store.rotation(handle);
+	std::println("Pose after a step with a NaN torque: ({}, {}, {}), {}", position.x, position.y, position.z, rotation);
+	assert(position.x == 1 && position.y == 2 && position.z == 3);
+	assert(rotation.w() == 1);
+
+	store.remove(handle);
+	store.setIntegrator(rl::Integrator::Euler);
+}
+
+void test_body()
+{
+	Vector6f tau;
+	tau << 1.0f, -2.0f, 3.0f, 0.4f, -0.5f, 0.6f;
+
+	// Body frame aligned with the principal axes.
+	Matrix3f principal;
+	principal << 2, 0, 0,
+				 0, 2, 0,
+				 0, 0, 4;
+
+	// Full tensor, e.g. computed from a mesh whose frame is not aligned with its principal axes.
+	Matrix3f full;
+	full << 3.0f, -0.2f, 0.1f,
+			-0.2f, 2.5f, -0.3f,
+			0.1f, -0.3f, 4.0f;
+
+	compareWithDense<float>(4.0f, principal, tau, 1e-5f);
+	compareWithDense<float>(1.5f, full, tau, 1e-5f);
+	compareWithDense<double>(4.0f, principal, tau, 1e-6);
+	compareWithDense<double>(1.5f, full, tau, 1e-6);
+
+	adaptiveStepRejectsNan();
+}
@@ -1,5 +1,13 @@
+#include "test_batch.h"
+#include "test_body.h"
+#include "test_mass.h"
+#include "test_pool.h"
 #include "test_quaternion.h"
 
 int main (int argc, char *argv[]) {
 	test_quaternion();
+	test_body();
+	test_mass();
+	test_batch();
+	test_pool();
 }
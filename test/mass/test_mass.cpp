@@ -0,0 +1,112 @@
+#include <cassert>
+#include <cmath>
+#include <print>
+#include <vector>
+#include "test_mass.h"
+
+/**
+ * @brief Appends a triangle to the non indexed vertex array of a mesh.
+ */
+static void triangle(std::vector<float> &vertices, const Eigen::Vector3f &a, const Eigen::Vector3f &b,
+	const Eigen::Vector3f &c)
+{
+	for (const auto *vertex : { &a, &b, &c }) {
+		vertices.insert(vertices.end(), { vertex->x(), vertex->y(), vertex->z() });
+	}
+}
+
+/**
+ * @brief Returns the surface of the box with every face split into divisions x divisions quads, facing outwards.
+ */
+static std::vector<float> box(const Eigen::Vector3f &min, const Eigen::Vector3f &max, int divisions)
+{
+	Eigen::Vector3f size = max - min;
+	Eigen::Vector3f x(size.x(), 0, 0), y(0, size.y(), 0), z(0, 0, size.z());
+
+	// Corner and edges of every face, the cross product of the edges points out of the box.
+	struct Face { Eigen::Vector3f origin, u, v; };
+	const Face faces[] = {
+		{ min, z, y }, { min + x, y, z },
+		{ min, x, z }, { min + y, z, x },
+		{ min, y, x }, { min + z, x, y },
+	};
+
+	std::vector<float> vertices;
+	for (const auto &face : faces) {
+		auto point = [&](int i, int j) -> Eigen::Vector3f {
+			return face.origin + face.u * (float(i) / divisions) + face.v * (float(j) / divisions);
+		};
+		for (int i = 0; i < divisions; ++i) {
+			for (int j = 0; j < divisions; ++j) {
+				triangle(vertices, point(i, j), point(i + 1, j), point(i + 1, j + 1));
+				triangle(vertices, point(i, j), point(i + 1, j + 1), point(i, j + 1));
+			}
+		}
+	}
+	return vertices;
+}
+
+static rl::MassProperties massProperties(std::vector<float> &vertices)
+{
+	::Mesh mesh{};
+	mesh.vertexCount = vertices.size() / 3;
+	mesh.triangleCount = vertices.size() / 9;
+	mesh.vertices = vertices.data();
+
+	::Model model{};
+	model.meshCount = 1;
+	model.meshes = &mesh;
+	return rl::MassProperties::fromModel(model);
+}
+
+static void expectNear(const Eigen::Matrix3f &actual, const Eigen::Matrix3f &expected, float tolerance)
+{
+	float error = (actual - expected).cwiseAbs().maxCoeff();
+	std::println("Largest error of the inertia tensor: {}", error);
+	assert(error <= tolerance);
+}
+
+void test_mass()
+{
+	// Unit cube, 300 triangles span more than one block of the integration.
+	auto cube = box(Eigen::Vector3f(-0.5f, -0.5f, -0.5f), Eigen::Vector3f(0.5f, 0.5f, 0.5f), 5);
+	auto properties = massProperties(cube);
+	std::println("Unit cube: volume {}, center of mass ({}, {}, {})", properties.volume,
+		properties.centerOfMass.x(), properties.centerOfMass.y(), properties.centerOfMass.z());
+	assert(std::abs(properties.volume - 1.0f) < 1e-5f);
+	assert(properties.centerOfMass.norm() < 1e-5f);
+	expectNear(properties.inertia, Eigen::Matrix3f::Identity() / 6.0f, 1e-5f);
+	expectNear(properties.inertiaFor(3.0f, 1.0f), Eigen::Matrix3f::Identity() * 0.5f, 1e-5f);
+
+	// Box of 2 x 1 x 1 centered at (3, 0, 0), the body rotates about the model origin.
+	auto offset = box(Eigen::Vector3f(2.0f, -0.5f, -0.5f), Eigen::Vector3f(4.0f, 0.5f, 0.5f), 1);
+	properties = massProperties(offset);
+	std::println("Offset box: volume {}, center of mass ({}, {}, {})", properties.volume,
+		properties.centerOfMass.x(), properties.centerOfMass.y(), properties.centerOfMass.z());
+	assert(std::abs(properties.volume - 2.0f) < 1e-5f);
+	assert((properties.centerOfMass - Eigen::Vector3f(3.0f, 0.0f, 0.0f)).norm() < 1e-5f);
+	expectNear(properties.inertia, Eigen::Vector3f(2.0f / 6.0f, 10.0f / 12.0f, 10.0f / 12.0f).asDiagonal(), 1e-5f);
+
+	// Mass 2 at the scale 2, the box is 4 x 2 x 2 centered at (6, 0, 0).
+	Eigen::Matrix3f expected = Eigen::Vector3f(2.0f * 8.0f / 12.0f, 2.0f * 20.0f / 12.0f + 2.0f * 36.0f,
+		2.0f * 20.0f / 12.0f + 2.0f * 36.0f).asDiagonal();
+	expectNear(properties.inertiaFor(2.0f, 2.0f), expected, 1e-4f);
+
+	// Square pyramid of unit base and height, 6 triangles do not fill the lanes of the integration.
+	std::vector<float> pyramid;
+	Eigen::Vector3f b0(-0.5f, -0.5f, 0.0f), b1(0.5f, -0.5f, 0.0f), b2(0.5f, 0.5f, 0.0f), b3(-0.5f, 0.5f, 0.0f);
+	Eigen::Vector3f apex(0.0f, 0.0f, 1.0f);
+	triangle(pyramid, b0, b3, b2);
+	triangle(pyramid, b0, b2, b1);
+	triangle(pyramid, b0, b1, apex);
+	triangle(pyramid, b1, b2, apex);
+	triangle(pyramid, b2, b3, apex);
+	triangle(pyramid, b3, b0, apex);
+	properties = massProperties(pyramid);
+	std::println("Pyramid: volume {}, center of mass ({}, {}, {})", properties.volume,
+		properties.centerOfMass.x(), properties.centerOfMass.y(), properties.centerOfMass.z());
+	assert(std::abs(properties.volume - 1.0f / 3.0f) < 1e-5f);
+	assert((properties.centerOfMass - Eigen::Vector3f(0.0f, 0.0f, 0.25f)).norm() < 1e-5f);
+	float side = (1.0f / 3.0f) * (1.0f / 20.0f + 3.0f / 80.0f);
+	expectNear(properties.inertia, Eigen::Vector3f(side, side, 1.0f / 30.0f).asDiagonal(), 1e-5f);
+}
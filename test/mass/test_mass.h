@@ -0,0 +1,5 @@
+#pragma once
+
+#include "mass.h"
+
+void test_mass();
@@ -0,0 +1,54 @@
+#include <cassert>
+#include <print>
+#include <vector>
+#include "test_pool.h"
+
+/**
+ * @brief Pooled type of the test, keeps its value so the reused slots can be told apart.
+ */
+struct Pooled
+{
+	explicit Pooled(int value) : value(value) {}
+
+	int value;
+};
+
+void test_pool()
+{
+	auto &pool = rl::Pool<Pooled>::instance();
+
+	// Reserving allocates all the chunks up front, creating the objects afterwards does not grow the pool.
+	pool.reserve(300);
+	size_t capacity = pool.capacity();
+	assert(capacity >= 300);
+
+	std::vector<Pooled *> objects;
+	for (int i = 0; i < 300; ++i) {
+		objects.push_back(pool.create(i));
+	}
+	assert(pool.size() == 300);
+	assert(pool.capacity() == capacity);
+
+	// The freed slot is reused by the next object, the handle of the destroyed object has to stay stale.
+	Pooled *freed = objects[42];
+	rl::PoolHandle stale = pool.handle(freed);
+	assert(pool.get(stale) == freed);
+
+	pool.destroy(freed);
+	assert(pool.get(stale) == nullptr);
+
+	Pooled *reused = pool.create(1000);
+	rl::PoolHandle fresh = pool.handle(reused);
+	assert(reused == freed);
+	assert(fresh.index == stale.index && fresh.generation != stale.generation);
+	assert(pool.get(stale) == nullptr);
+	assert(pool.get(fresh) == reused && reused->value == 1000);
+	assert(pool.get(rl::PoolHandle{}) == nullptr);
+	objects[42] = reused;
+
+	for (Pooled *object : objects) {
+		pool.destroy(object);
+	}
+	assert(pool.size() == 0);
+	std::println("Pool of {} slots rejects the stale handle of slot {} after its reuse", capacity, stale.index);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "pool.h"
+
+void test_pool();
@@ -1,6 +1,71 @@
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include "simd.h"
 #include "test_quaternion.h"
 
+/**
+ * @brief Rotates, multiplies and integrates a pack of quaternions and computes the rigid body terms of a pack of
+ * bodies, every lane has to match the float path of its quaternion.
+ */
+static void comparePacks()
+{
+	using Pack = rl::FloatPack;
+	constexpr float dt = 1.0f / 240.0f;
+	auto lane = [](float offset, float scale) { return Pack([=](auto i) { return offset + scale * float(i()); }); };
+
+	rl::BasicQuaternion<Pack> q(lane(0.1f, 0.05f), lane(-0.3f, 0.1f), lane(0.7f, -0.02f), lane(0.5f, 0.03f));
+	rl::BasicQuaternion<Pack> p = rl::BasicQuaternion<Pack>::fromEuler(lane(0.2f, 0.1f), lane(-1.0f, 0.3f), lane(0.4f, 0.0f));
+	rl::Vec3<Pack> v(lane(1.0f, 0.5f), lane(-2.0f, 0.25f), lane(0.5f, -0.1f));
+	rl::Vec3<Pack> omega(lane(0.3f, 0.2f), lane(-0.1f, 0.4f), lane(2.0f, -0.3f));
+	rl::Mat3<Pack> inertia;
+	inertia << lane(2.0f, 0.1f), Pack(0.1f), Pack(0.0f),
+		Pack(0.1f), lane(3.0f, 0.2f), Pack(0.0f),
+		Pack(0.0f), Pack(0.0f), lane(1.5f, 0.3f);
+
+	q.normalize();
+	rl::Vec3<Pack> rotated = q.rotateVector(v);
+	rl::BasicQuaternion<Pack> product = q * p;
+	rl::BasicQuaternion<Pack> integrated = q;
+	integrated.integrate(omega, Pack(dt)).normalize();
+	rl::Vec3<Pack> gyroscopic = (inertia * omega).cross(omega);
+
+	float error = 0.0f;
+	auto compare = [&error](float expected, float actual) {
+		error = std::max(error, std::abs(expected - actual));
+	};
+	for (size_t i = 0; i < Pack::size(); ++i) {
+		rl::Quaternion qs(q.x()[i], q.y()[i], q.z()[i], q.w()[i]);
+		rl::Quaternion ps(p.x()[i], p.y()[i], p.z()[i], p.w()[i]);
+		Vector3f vs(v.x()[i], v.y()[i], v.z()[i]);
+		Vector3f omegas(omega.x()[i], omega.y()[i], omega.z()[i]);
+		Matrix3f inertias;
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) {
+				inertias(r, c) = inertia(r, c)[i];
+			}
+		}
+
+		compare(1.0f, qs.magnitude());
+		Vector3f rotateds = qs.rotateVector(vs);
+		rl::Quaternion products = qs * ps;
+		rl::Quaternion integrateds = qs;
+		integrateds.integrate(omegas, dt).normalize();
+		Vector3f gyroscopics = (inertias * omegas).cross(omegas);
+		for (int c = 0; c < 3; ++c) {
+			compare(rotateds[c], rotated[c][i]);
+			compare(gyroscopics[c], gyroscopic[c][i]);
+		}
+		for (int c = 0; c < 4; ++c) {
+			compare(products.data()[c], product.data()[c][i]);
+			compare(integrateds.data()[c], integrated.data()[c][i]);
+		}
+	}
+
+	std::println("Packs of {} quaternions match rl::Quaternion, largest error: {}", Pack::size(), error);
+	assert(error < 1e-5f);
+}
+
 void test_quaternion()
 {
 
@@ -33,4 +98,6 @@ void test_quaternion()
 
 	auto rotated_vector = q.rotate(Vector3{1, 2, 3});
 	std::println("Rotated Vector: {}", rotated_vector);
+
+	comparePacks();
 }